@@ -0,0 +1,240 @@
+#include "Benchmark.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include "GpuTiledSimulation.h"
+#include "Random.h"
+#include "Texture2D.h"
+#include "TraceRecorder.h"
+
+BenchmarkConfig::BenchmarkConfig()
+{
+    for (int i = 0; i < (int)KernelGenerationType::COUNT_; ++i)
+    {
+        kernelTypes.push_back((KernelGenerationType)i);
+    }
+    for (int i = 0; i < (int)EngineType::COUNT_; ++i)
+    {
+        engines.push_back((EngineType)i);
+    }
+}
+
+BenchmarkConfig BenchmarkConfig::createQuick()
+{
+    BenchmarkConfig config;
+    config.gridSizes = { 256, 1024 };
+    config.neighborSearchRanges = { 1, 5, 10 };
+    config.densities = { 0.3f };
+    config.minSecondsPerCase = 0.1;
+    return config;
+}
+
+static std::vector<uint8_t> createCells(int width, int height, float density, unsigned int seed)
+{
+    std::mt19937 engine(seed);
+    std::bernoulli_distribution distribution(density);
+
+    std::vector<uint8_t> cells((size_t)width * height);
+    for (uint8_t& cell : cells)
+    {
+        cell = distribution(engine) ? 1 : 0;
+    }
+    return cells;
+}
+
+BenchmarkResult Benchmark::measure(double minSeconds, int maxGenerations, const std::function<void(int)>& stepGenerations)
+{
+    stepGenerations(1);
+
+    BenchmarkResult result;
+    int batch = 1;
+    while (result.seconds < minSeconds && result.generations < maxGenerations)
+    {
+        int count = std::min(batch, maxGenerations - result.generations);
+
+        auto start = std::chrono::steady_clock::now();
+        stepGenerations(count);
+        result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        result.generations += count;
+        batch *= 2;
+    }
+    return result;
+}
+
+bool Benchmark::run(const BenchmarkConfig& config, const std::filesystem::path& outputPath)
+{
+    std::ofstream file(outputPath);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open benchmark file for writing: " << outputPath.string() << std::endl;
+        return false;
+    }
+    file << "engine,grid_width,grid_height,radius,kernel_type,density,kernel_taps,generations,seconds,cells_per_second,ns_per_cell,status\n";
+
+    bool hasGpuEngine = std::find(config.engines.begin(), config.engines.end(), EngineType::GpuCompute) != config.engines.end();
+    bool hasCpuEngine = std::any_of(config.engines.begin(), config.engines.end(), [](EngineType type) { return type != EngineType::GpuCompute; });
+
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
+    std::vector<std::unique_ptr<CpuEngine>> cpuEngines;
+    for (EngineType type : config.engines)
+    {
+        std::unique_ptr<CpuEngine> engine = CpuEngine::create(type);
+        if (engine)
+        {
+            cpuEngines.push_back(std::move(engine));
+        }
+    }
+
+    for (int size : config.gridSizes)
+    {
+        // GPU resources are created once per size, the largest sizes are split into tiles
+        std::unique_ptr<Texture2D> textureA;
+        std::unique_ptr<Texture2D> textureB;
+        std::unique_ptr<Simulation> gpuSimulation;
+        std::unique_ptr<GpuTiledSimulation> gpuTiledSimulation;
+        if (hasGpuEngine && size <= maxTextureSize)
+        {
+            while (glGetError() != GL_NO_ERROR) {}
+            textureA = std::make_unique<Texture2D>(size, size);
+            textureB = std::make_unique<Texture2D>(size, size);
+            if (glGetError() == GL_NO_ERROR)
+            {
+                gpuSimulation = std::make_unique<Simulation>(size, size, *textureA, *textureB);
+            }
+        }
+        // Sizes that only split into tiny tiles are reported instead of measured with halo copies dominating
+        bool isUntileable = false;
+        if (hasGpuEngine && !gpuSimulation)
+        {
+            textureA.reset();
+            textureB.reset();
+            isUntileable = !GpuTiledSimulation::canSplit(size, size);
+            if (!isUntileable)
+            {
+                gpuTiledSimulation = std::make_unique<GpuTiledSimulation>(size, size);
+                gpuTiledSimulation->maxResidentTiles = std::max<size_t>(config.maxGpuTiledBytes / gpuTiledSimulation->getTileBytes(), 1);
+            }
+        }
+
+        CpuWorld world;
+        if (hasCpuEngine)
+        {
+            world.resize(size, size);
+        }
+
+        for (int range : config.neighborSearchRanges)
+        {
+            for (KernelGenerationType kernelType : config.kernelTypes)
+            {
+                Random::Seed(config.seed + range * 101 + (int)kernelType);
+                SimulationRules rules = SimulationRules::createTestRules(range, kernelType);
+                int taps = (range * 2 + 1) * (range * 2 + 1);
+                double cellTaps = (double)size * size * taps;
+
+                for (float density : config.densities)
+                {
+                    std::vector<uint8_t> cells = createCells(size, size, density, config.seed);
+
+                    for (EngineType engineType : config.engines)
+                    {
+                        std::string caseName = std::string(ENGINE_TYPE_NAMES[(int)engineType]) + " " + std::to_string(size) + " r" + std::to_string(range);
+                        ScopedTraceEvent trace("Benchmark case", "benchmark", caseName);
+
+                        BenchmarkResult result;
+                        if (engineType == EngineType::GpuCompute)
+                        {
+                            if (gpuTiledSimulation)
+                            {
+                                if (!gpuTiledSimulation->setRules(rules))
+                                {
+                                    result.status = "unsupported";
+                                }
+                                else
+                                {
+                                    gpuTiledSimulation->setCells(cells);
+                                    result = measure(config.minSecondsPerCase, config.maxGenerationsPerCase, [&](int generations)
+                                        {
+                                            gpuTiledSimulation->step(generations);
+                                            glFinish();
+                                        });
+                                    result.status = "tiled";
+                                }
+                            }
+                            else if (!gpuSimulation)
+                            {
+                                result.status = isUntileable ? "untileable" : "unsupported";
+                            }
+                            else
+                            {
+                                gpuSimulation->rules = rules;
+                                gpuSimulation->submitRulesToShader();
+                                gpuSimulation->setCells(cells);
+                                result = measure(config.minSecondsPerCase, config.maxGenerationsPerCase, [&](int generations)
+                                    {
+                                        gpuSimulation->step(generations);
+                                        glFinish();
+                                    });
+                            }
+                        }
+                        else
+                        {
+                            auto it = std::find_if(cpuEngines.begin(), cpuEngines.end(), [engineType](const auto& e) { return e->getType() == engineType; });
+                            CpuEngine* engine = it != cpuEngines.end() ? it->get() : nullptr;
+                            if (!engine || !engine->supports(rules))
+                            {
+                                result.status = "unsupported";
+                            }
+                            else if (cellTaps > config.maxCpuCellTapsPerCase)
+                            {
+                                result.status = "skipped";
+                            }
+                            else
+                            {
+                                engine->setRules(rules);
+                                world.cells = cells;
+                                engine->invalidate();
+                                result = measure(config.minSecondsPerCase, config.maxGenerationsPerCase, [&](int generations)
+                                    {
+                                        for (int i = 0; i < generations; ++i)
+                                        {
+                                            engine->step(world);
+                                        }
+                                    });
+                            }
+                        }
+
+                        double cellsPerSecond = result.seconds > 0.0 ? (double)size * size * result.generations / result.seconds : 0.0;
+                        double nsPerCell = cellsPerSecond > 0.0 ? 1.0e9 / cellsPerSecond : 0.0;
+
+                        file << ENGINE_TYPE_NAMES[(int)engineType] << ',' << size << ',' << size << ',' << range << ','
+                            << KERNEL_GENERATION_TYPE_NAMES[(int)kernelType] << ',' << density << ',' << taps << ','
+                            << result.generations << ',' << result.seconds << ',' << cellsPerSecond << ',' << nsPerCell << ','
+                            << result.status << '\n';
+                        file.flush();
+
+                        std::cout << caseName << " " << KERNEL_GENERATION_TYPE_NAMES[(int)kernelType] << " d" << density << ": ";
+                        if (result.generations > 0)
+                        {
+                            std::cout << cellsPerSecond / 1.0e6 << " Mcells/s" << std::endl;
+                        }
+                        else
+                        {
+                            std::cout << result.status << std::endl;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << "Benchmark results written to " << outputPath.string() << std::endl;
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <vector>
+#include "CpuEngine.h"
+#include "Simulation.h"
+
+struct BenchmarkConfig
+{
+    std::vector<int> gridSizes = { 256, 512, 1024, 2048, 4096, 8192, 16384 };
+    std::vector<int> neighborSearchRanges = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    std::vector<float> densities = { 0.1f, 0.3f, 0.5f };
+    std::vector<KernelGenerationType> kernelTypes;
+    std::vector<EngineType> engines;
+
+    double minSecondsPerCase = 0.2;
+    int maxGenerationsPerCase = 1000;
+    double maxCpuCellTapsPerCase = 2.0e10; // Cases above this estimate are reported as skipped on the CPU
+    size_t maxGpuTiledBytes = (size_t)1 << 30; // VRAM for tiles of worlds that do not fit in one texture
+    unsigned int seed = 12345;
+
+    BenchmarkConfig(); // All kernel types and all engines
+    static BenchmarkConfig createQuick();
+};
+
+struct BenchmarkResult
+{
+    int generations = 0;
+    double seconds = 0.0;
+    const char* status = "ok";
+};
+
+// Benchmark class for measuring cells per second of every engine.
+// Each case steps a seeded world for at least minSecondsPerCase and is written as one CSV row,
+// so runs can be compared between builds and engines.
+class Benchmark
+{
+public:
+    Benchmark() = delete;
+
+    // Needs a current OpenGL context for the GPU engine
+    static bool run(const BenchmarkConfig& config, const std::filesystem::path& outputPath);
+
+    // One warm-up call, then batches of doubling size until minSeconds is spent or maxGenerations are done
+    static BenchmarkResult measure(double minSeconds, int maxGenerations, const std::function<void(int)>& stepGenerations);
+};
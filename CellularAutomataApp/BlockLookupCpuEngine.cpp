@@ -0,0 +1,185 @@
+#include "BlockLookupCpuEngine.h"
+#include <list>
+#include <mutex>
+#include <utility>
+#include "ThreadPool.h"
+
+EngineType BlockLookupCpuEngine::getType() const
+{
+    return EngineType::BlockLookupCpu;
+}
+
+bool BlockLookupCpuEngine::supports(const SimulationRules& rules) const
+{
+    return rules.neighborSearchRange == 1 && rules.kernel.size() == 9;
+}
+
+void BlockLookupCpuEngine::setRules(const SimulationRules& rules)
+{
+    tables = getTables(rules);
+}
+
+std::shared_ptr<const BlockLookupCpuEngine::LookupTables> BlockLookupCpuEngine::getTables(const SimulationRules& rules)
+{
+    // Most recently used first
+    static std::mutex mutex;
+    static std::list<std::pair<uint64_t, std::shared_ptr<const LookupTables>>> cache;
+
+    uint64_t hash = rules.getHash();
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = cache.begin(); it != cache.end(); ++it)
+    {
+        if (it->first == hash)
+        {
+            cache.splice(cache.begin(), cache, it);
+            return cache.front().second;
+        }
+    }
+
+    cache.emplace_front(hash, createTables(rules));
+    if (cache.size() > CACHED_TABLES_COUNT)
+    {
+        cache.pop_back();
+    }
+    return cache.front().second;
+}
+
+std::shared_ptr<const BlockLookupCpuEngine::LookupTables> BlockLookupCpuEngine::createTables(const SimulationRules& rules)
+{
+    auto tables = std::make_shared<LookupTables>();
+
+    TransitionRanges ranges;
+    ranges.set(rules);
+    for (int pattern = 0; pattern < (1 << 9); ++pattern)
+    {
+        // Same order as the shader, y outer and x inner
+        float sum = 0.0f;
+        for (int index = 0; index < 9; ++index)
+        {
+            sum += float((pattern >> index) & 1) * rules.kernel[index];
+        }
+        tables->cells[pattern] = ranges.apply((pattern >> 4) & 1, sum);
+    }
+
+    for (int block = 0; block < (1 << 16); ++block)
+    {
+        uint8_t center = 0;
+        for (int y = 0; y < 2; ++y)
+        {
+            for (int x = 0; x < 2; ++x)
+            {
+                int pattern = 0;
+                for (int ky = 0; ky < 3; ++ky)
+                {
+                    for (int kx = 0; kx < 3; ++kx)
+                    {
+                        pattern |= ((block >> ((y + ky) * 4 + x + kx)) & 1) << (ky * 3 + kx);
+                    }
+                }
+                center |= tables->cells[pattern] << (y * 2 + x);
+            }
+        }
+        tables->blocks[block] = center;
+    }
+    return tables;
+}
+
+void BlockLookupCpuEngine::step(CpuWorld& world)
+{
+    const int w = world.width;
+    const int h = world.height;
+
+    // One wrapped column on the left and two on the right, so the last block of an even row can slide in
+    const int paddedWidth = w + 3;
+
+    const uint8_t* current = world.cells.data();
+    uint8_t* next = world.getScratch();
+
+    paddedCells.resize((size_t)paddedWidth * h);
+    ThreadPool::parallelFor(0, h, [&](int rowBegin, int rowEnd)
+        {
+            for (int y = rowBegin; y < rowEnd; ++y)
+            {
+                const uint8_t* source = current + (size_t)y * w;
+                uint8_t* padded = paddedCells.data() + (size_t)y * paddedWidth;
+                for (int i = 0; i < paddedWidth; ++i)
+                {
+                    padded[i] = source[((i - 1) % w + w) % w];
+                }
+            }
+        });
+
+    const LookupTables& lookup = *tables;
+    const int blocksW = w / 2;
+    const int blocksH = h / 2;
+
+    // The odd last row and column of odd sized worlds go through the cell table
+    auto stepCell = [&](int x, int y)
+        {
+            int pattern = 0;
+            for (int ky = 0; ky < 3; ++ky)
+            {
+                const uint8_t* row = paddedCells.data() + (size_t)((y + ky - 1 + h) % h) * paddedWidth;
+                for (int kx = 0; kx < 3; ++kx)
+                {
+                    pattern |= row[x + kx] << (ky * 3 + kx);
+                }
+            }
+            next[(size_t)y * w + x] = lookup.cells[pattern];
+        };
+
+    ThreadPool::parallelFor(0, blocksH, [&](int blockRowBegin, int blockRowEnd)
+        {
+            for (int by = blockRowBegin; by < blockRowEnd; ++by)
+            {
+                int y = by * 2;
+                const uint8_t* rows[4];
+                for (int i = 0; i < 4; ++i)
+                {
+                    rows[i] = paddedCells.data() + (size_t)((y + i - 1 + h) % h) * paddedWidth;
+                }
+                uint8_t* nextRow0 = next + (size_t)y * w;
+                uint8_t* nextRow1 = nextRow0 + w;
+
+                // Every nibble holds 4 columns of one row, sliding two columns per block
+                unsigned int nibbles[4];
+                for (int i = 0; i < 4; ++i)
+                {
+                    nibbles[i] = rows[i][0] | (rows[i][1] << 1);
+                }
+                for (int bx = 0; bx < blocksW; ++bx)
+                {
+                    int x = bx * 2;
+                    int block = 0;
+                    for (int i = 0; i < 4; ++i)
+                    {
+                        nibbles[i] = (nibbles[i] & 0x3) | (rows[i][x + 2] << 2) | (rows[i][x + 3] << 3);
+                        block |= nibbles[i] << (i * 4);
+                        nibbles[i] >>= 2;
+                    }
+
+                    uint8_t center = lookup.blocks[block];
+                    nextRow0[x] = center & 1;
+                    nextRow0[x + 1] = (center >> 1) & 1;
+                    nextRow1[x] = (center >> 2) & 1;
+                    nextRow1[x + 1] = (center >> 3) & 1;
+                }
+
+                if (w % 2 != 0)
+                {
+                    stepCell(w - 1, y);
+                    stepCell(w - 1, y + 1);
+                }
+            }
+        });
+
+    if (h % 2 != 0)
+    {
+        for (int x = 0; x < w; ++x)
+        {
+            stepCell(x, h - 1);
+        }
+    }
+
+    world.swapBuffers();
+}
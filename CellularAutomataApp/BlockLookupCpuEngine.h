@@ -0,0 +1,30 @@
+#pragma once
+#include <memory>
+#include "CpuEngine.h"
+
+// BlockLookupCpuEngine class for radius 1 rules.
+// A table maps every 4x4 block of cells to the next generation of its 2x2 center, so one lookup steps
+// four cells. Entries are computed with the shader's float sum of every pattern, which makes them exact
+// for any radius 1 kernel. Tables are built when the rules are set and cached by the rules hash.
+class BlockLookupCpuEngine : public CpuEngine
+{
+public:
+    EngineType getType() const override;
+    bool supports(const SimulationRules& rules) const override;
+    void setRules(const SimulationRules& rules) override;
+    void step(CpuWorld& world) override;
+private:
+    struct LookupTables
+    {
+        uint8_t cells[1 << 9];   // 3x3 neighborhood, bit ky * 3 + kx -> next state of the center
+        uint8_t blocks[1 << 16]; // 4x4 block, bit row * 4 + column -> next 2x2 center, bit y * 2 + x
+    };
+
+    static const int CACHED_TABLES_COUNT = 16;
+
+    std::shared_ptr<const LookupTables> tables;
+    std::vector<uint8_t> paddedCells;
+
+    static std::shared_ptr<const LookupTables> getTables(const SimulationRules& rules);
+    static std::shared_ptr<const LookupTables> createTables(const SimulationRules& rules);
+};
@@ -0,0 +1,175 @@
+#include "ChangeListCpuEngine.h"
+#include "ThreadPool.h"
+
+EngineType ChangeListCpuEngine::getType() const
+{
+    return EngineType::ChangeListCpu;
+}
+
+bool ChangeListCpuEngine::supports(const SimulationRules& rules) const
+{
+    return rules.getFixedPointRules().isValid();
+}
+
+void ChangeListCpuEngine::setRules(const SimulationRules& rules)
+{
+    kernel = SparseKernel::compile(rules);
+    invalidate();
+}
+
+void ChangeListCpuEngine::invalidate()
+{
+    areSumsValid = false;
+}
+
+void ChangeListCpuEngine::step(CpuWorld& world)
+{
+    size_t cellsCount = world.cells.size();
+    if (sums.size() != cellsCount)
+    {
+        sums.assign(cellsCount, 0);
+        isCandidate.assign(cellsCount, 0);
+        candidates.clear();
+        areSumsValid = false;
+    }
+
+    bool isDense = !areSumsValid;
+    if (isDense)
+    {
+        stepDense(world);
+    }
+    else
+    {
+        stepChanges(world);
+    }
+
+    // Updating the sums costs every tap of every flip, above the limit a dense generation is cheaper
+    if (flips.size() > maxChangedFraction * cellsCount)
+    {
+        if (isDense)
+        {
+            world.swapBuffers();
+        }
+        else
+        {
+            for (int flip : flips)
+            {
+                world.cells[flip] ^= 1;
+            }
+        }
+        areSumsValid = false;
+        return;
+    }
+    applyFlips(world);
+}
+
+void ChangeListCpuEngine::stepDense(CpuWorld& world)
+{
+    const int w = world.width;
+    const int h = world.height;
+    const uint8_t* current = world.cells.data();
+    uint8_t* next = world.getScratch();
+    const TransitionTable& transitions = kernel.fixedPoint.transitions;
+
+    ThreadPool::parallelFor(0, h, [&](int rowBegin, int rowEnd)
+        {
+            for (int y = rowBegin; y < rowEnd; ++y)
+            {
+                for (int x = 0; x < w; ++x)
+                {
+                    int sum = 0;
+                    for (const KernelTapGroup& group : kernel.groups)
+                    {
+                        int count = 0;
+                        for (int i = group.firstTap; i < group.firstTap + group.tapCount; ++i)
+                        {
+                            const KernelTap& tap = kernel.taps[i];
+                            int neighborX = ((x + tap.dx) % w + w) % w;
+                            int neighborY = ((y + tap.dy) % h + h) % h;
+                            count += current[(size_t)neighborY * w + neighborX];
+                        }
+                        sum += count * group.fixedWeight;
+                    }
+
+                    size_t index = (size_t)y * w + x;
+                    sums[index] = (int16_t)sum;
+                    next[index] = transitions.getNextState(current[index], sum);
+                }
+            }
+        });
+
+    flips.clear();
+    for (size_t i = 0; i < world.cells.size(); ++i)
+    {
+        if (world.cells[i] != next[i])
+        {
+            flips.push_back((int)i);
+        }
+    }
+
+    // The sums still describe the current cells, applyFlips() moves them to the next generation
+    for (int candidate : candidates)
+    {
+        isCandidate[candidate] = 0;
+    }
+    candidates.clear();
+    areSumsValid = true;
+}
+
+void ChangeListCpuEngine::stepChanges(CpuWorld& world)
+{
+    const TransitionTable& transitions = kernel.fixedPoint.transitions;
+
+    flips.clear();
+    for (int candidate : candidates)
+    {
+        isCandidate[candidate] = 0;
+        uint8_t cell = world.cells[candidate];
+        if (transitions.getNextState(cell, sums[candidate]) != cell)
+        {
+            flips.push_back(candidate);
+        }
+    }
+    candidates.clear();
+}
+
+void ChangeListCpuEngine::applyFlips(CpuWorld& world)
+{
+    const int w = world.width;
+    const int h = world.height;
+
+    for (int flip : flips)
+    {
+        int x = flip % w;
+        int y = flip / w;
+        uint8_t cell = world.cells[flip] ^ 1;
+        world.cells[flip] = cell;
+        int delta = cell ? 1 : -1;
+
+        if (!isCandidate[flip])
+        {
+            isCandidate[flip] = 1;
+            candidates.push_back(flip);
+        }
+
+        // The cell at (x - dx, y - dy) sees this one through tap (dx, dy)
+        for (const KernelTapGroup& group : kernel.groups)
+        {
+            int16_t change = (int16_t)(delta * group.fixedWeight);
+            for (int i = group.firstTap; i < group.firstTap + group.tapCount; ++i)
+            {
+                const KernelTap& tap = kernel.taps[i];
+                int neighborX = ((x - tap.dx) % w + w) % w;
+                int neighborY = ((y - tap.dy) % h + h) % h;
+
+                int neighbor = neighborY * w + neighborX;
+                sums[neighbor] += change;
+                if (!isCandidate[neighbor])
+                {
+                    isCandidate[neighbor] = 1;
+                    candidates.push_back(neighbor);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "CpuEngine.h"
+#include "SparseKernel.h"
+
+// ChangeListCpuEngine class for very sparse dynamics, such as a few gliders in a frozen world.
+// The exact neighbor sum of every cell is kept between generations. A generation only evaluates cells
+// whose state or sum changed, and every flipped cell adds or subtracts its weight from the sums of the
+// cells that see it. When too many cells change, the sums are dropped and the world is stepped densely
+// until the changes are sparse again. Sums are only exact in integers, so fixed-point kernels are required.
+class ChangeListCpuEngine : public CpuEngine
+{
+public:
+    EngineType getType() const override;
+    bool supports(const SimulationRules& rules) const override;
+    void setRules(const SimulationRules& rules) override;
+    void step(CpuWorld& world) override;
+    void invalidate() override;
+
+    float maxChangedFraction = 0.05f; // Dense stepping above this fraction of changed cells
+private:
+    SparseKernel kernel;
+    std::vector<int16_t> sums;        // Fixed-point neighbor sum of every cell
+    bool areSumsValid = false;
+    std::vector<int> candidates;      // Cells to evaluate in the next generation
+    std::vector<uint8_t> isCandidate;
+    std::vector<int> flips;
+
+    void stepDense(CpuWorld& world);
+    void stepChanges(CpuWorld& world);
+    void applyFlips(CpuWorld& world); // Updates the sums and collects the next candidates
+};
@@ -0,0 +1,92 @@
+#include "ChunkMap.h"
+
+const size_t INITIAL_CAPACITY = 64;
+
+ChunkMap::ChunkMap()
+    : entries(INITIAL_CAPACITY), mask(INITIAL_CAPACITY - 1)
+{
+}
+
+size_t ChunkMap::getSlot(ChunkCoord coord) const
+{
+    // Fibonacci hashing, the high bits mix both coordinates
+    uint64_t key = ((uint64_t)(uint32_t)coord.x << 32) | (uint32_t)coord.y;
+    uint64_t hash = (key ^ (key >> 29)) * 0x9E3779B97F4A7C15ull;
+    return (size_t)(hash >> 32) & mask;
+}
+
+uint8_t* ChunkMap::find(ChunkCoord coord) const
+{
+    for (size_t slot = getSlot(coord);; slot = (slot + 1) & mask)
+    {
+        const Entry& entry = entries[slot];
+        if (!entry.isUsed)
+        {
+            return nullptr;
+        }
+        if (entry.coord.x == coord.x && entry.coord.y == coord.y)
+        {
+            return entry.cells;
+        }
+    }
+}
+
+bool ChunkMap::insert(ChunkCoord coord, uint8_t* cells)
+{
+    if ((size + 1) * 2 > entries.size())
+    {
+        grow();
+    }
+
+    for (size_t slot = getSlot(coord);; slot = (slot + 1) & mask)
+    {
+        Entry& entry = entries[slot];
+        if (!entry.isUsed)
+        {
+            entry.coord = coord;
+            entry.cells = cells;
+            entry.isUsed = true;
+            size++;
+            return true;
+        }
+        if (entry.coord.x == coord.x && entry.coord.y == coord.y)
+        {
+            return false;
+        }
+    }
+}
+
+void ChunkMap::clear()
+{
+    for (Entry& entry : entries)
+    {
+        entry.isUsed = false;
+    }
+    size = 0;
+}
+
+size_t ChunkMap::getSize() const
+{
+    return size;
+}
+
+const std::vector<ChunkMap::Entry>& ChunkMap::getEntries() const
+{
+    return entries;
+}
+
+void ChunkMap::grow()
+{
+    std::vector<Entry> oldEntries(entries.size() * 2);
+    oldEntries.swap(entries);
+    mask = entries.size() - 1;
+    size = 0;
+
+    for (const Entry& entry : oldEntries)
+    {
+        if (entry.isUsed)
+        {
+            insert(entry.coord, entry.cells);
+        }
+    }
+}
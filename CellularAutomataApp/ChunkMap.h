@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct ChunkCoord
+{
+    int32_t x = 0;
+    int32_t y = 0;
+};
+
+// ChunkMap class, an open-addressing hash map from chunk coordinates to chunk cells.
+// Linear probing over a power-of-two table kept at most half full; there is no erase,
+// maps are rebuilt every generation, so probe sequences never contain holes.
+class ChunkMap
+{
+public:
+    struct Entry
+    {
+        ChunkCoord coord;
+        uint8_t* cells = nullptr;
+        bool isUsed = false;
+    };
+
+    ChunkMap();
+
+    uint8_t* find(ChunkCoord coord) const; // nullptr when missing
+    bool insert(ChunkCoord coord, uint8_t* cells); // False when the coord is already present, its cells are kept
+    void clear();
+    size_t getSize() const;
+
+    // Used and unused entries in table order
+    const std::vector<Entry>& getEntries() const;
+private:
+    std::vector<Entry> entries;
+    size_t size = 0;
+    size_t mask = 0;
+
+    size_t getSlot(ChunkCoord coord) const;
+    void grow();
+};
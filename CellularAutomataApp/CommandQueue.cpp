@@ -0,0 +1,49 @@
+#include "CommandQueue.h"
+
+CommandQueue::~CommandQueue()
+{
+    Node* node = head.exchange(nullptr);
+    while (node)
+    {
+        Node* next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+void CommandQueue::push(Command command)
+{
+    Node* node = new Node{ std::move(command), head.load(std::memory_order_relaxed) };
+    while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+int CommandQueue::runAll(Simulation& simulation)
+{
+    Node* node = takeInOrder(head.exchange(nullptr, std::memory_order_acquire));
+    int count = 0;
+    while (node)
+    {
+        node->command(simulation);
+        Node* next = node->next;
+        delete node;
+        node = next;
+        count++;
+    }
+    return count;
+}
+
+CommandQueue::Node* CommandQueue::takeInOrder(Node* list)
+{
+    // The list is newest first
+    Node* reversed = nullptr;
+    while (list)
+    {
+        Node* next = list->next;
+        list->next = reversed;
+        reversed = list;
+        list = next;
+    }
+    return reversed;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <atomic>
+#include <functional>
+
+class Simulation;
+
+// CommandQueue class, a lock-free queue of commands from any number of threads to one consumer thread.
+// push() links a node onto an atomic list head with a compare-exchange; the consumer takes the whole
+// list with a single exchange and reverses it, so commands run in the order they were pushed and a node
+// is never taken while a producer can still touch it.
+class CommandQueue
+{
+public:
+    using Command = std::function<void(Simulation&)>;
+
+    CommandQueue() = default;
+    ~CommandQueue();
+    CommandQueue(const CommandQueue&) = delete;
+    CommandQueue& operator=(const CommandQueue&) = delete;
+
+    void push(Command command);
+    int runAll(Simulation& simulation); // Consumer thread, returns the number of commands run
+private:
+    struct Node
+    {
+        Command command;
+        Node* next = nullptr;
+    };
+
+    std::atomic<Node*> head{ nullptr };
+
+    static Node* takeInOrder(Node* list);
+};
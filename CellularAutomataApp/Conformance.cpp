@@ -0,0 +1,365 @@
+#include "Conformance.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include "Random.h"
+#include "Texture2D.h"
+#include "TraceRecorder.h"
+
+struct ConformanceCase
+{
+    ConformanceGrid grid;
+    int neighborSearchRange = 1;
+    KernelGenerationType kernelType = KernelGenerationType::RandomAllValues;
+    SimulationRules rules;
+    std::vector<uint8_t> cells;
+};
+
+struct GoldenCase
+{
+    uint64_t rulesHash = 0;
+    std::vector<uint64_t> hashes; // Generation 0 is the initial state
+};
+
+using GoldenKey = std::tuple<int, int, int, int>; // Width, height, neighbor search range, kernel type
+
+ConformanceConfig::ConformanceConfig()
+{
+    for (int i = 0; i < (int)KernelGenerationType::COUNT_; ++i)
+    {
+        kernelTypes.push_back((KernelGenerationType)i);
+    }
+    for (int i = 0; i < (int)EngineType::COUNT_; ++i)
+    {
+        engines.push_back((EngineType)i);
+    }
+}
+
+uint64_t Conformance::hashCells(int width, int height, const std::vector<uint8_t>& cells)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto addBytes = [&hash](const void* data, size_t size)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+        };
+
+    addBytes(&width, sizeof(width));
+    addBytes(&height, sizeof(height));
+    addBytes(cells.data(), cells.size());
+    return hash;
+}
+
+static ConformanceCase createCase(const ConformanceConfig& config, const ConformanceGrid& grid, int range, KernelGenerationType kernelType)
+{
+    ConformanceCase testCase;
+    testCase.grid = grid;
+    testCase.neighborSearchRange = range;
+    testCase.kernelType = kernelType;
+
+    Random::Seed(config.seed + range * 101 + (int)kernelType);
+    testCase.rules = SimulationRules::createTestRules(range, kernelType);
+
+    // Raw generator output is the same with every standard library, distributions are not
+    std::mt19937 engine(config.seed + range * 7919 + (int)kernelType);
+    uint32_t threshold = static_cast<uint32_t>(config.density * 4294967295.0);
+    testCase.cells.resize((size_t)grid.width * grid.height);
+    for (uint8_t& cell : testCase.cells)
+    {
+        cell = engine() < threshold ? 1 : 0;
+    }
+    return testCase;
+}
+
+static std::string getCaseName(const ConformanceCase& testCase)
+{
+    return std::to_string(testCase.grid.width) + "x" + std::to_string(testCase.grid.height) + " r" + std::to_string(testCase.neighborSearchRange)
+        + " " + KERNEL_GENERATION_TYPE_NAMES[(int)testCase.kernelType];
+}
+
+static std::string getHeader(const ConformanceConfig& config)
+{
+    std::ostringstream header;
+    header << "conformance";
+    for (const ConformanceGrid& grid : config.grids)
+    {
+        header << '\t' << grid.width << 'x' << grid.height;
+    }
+    header << '\t' << config.generations << '\t' << config.density << '\t' << config.seed;
+    return header.str();
+}
+
+// Steps the case with one engine and keeps every generation
+static void runEngine(
+    const ConformanceConfig& config,
+    const ConformanceCase& testCase,
+    Simulation* gpuSimulation,
+    CpuEngine* cpuEngine,
+    std::vector<std::vector<uint8_t>>& states
+)
+{
+    states.clear();
+    if (gpuSimulation)
+    {
+        gpuSimulation->rules = testCase.rules;
+        gpuSimulation->submitRulesToShader();
+        gpuSimulation->setCells(testCase.cells);
+        states.push_back(gpuSimulation->getCells());
+        for (int i = 0; i < config.generations; ++i)
+        {
+            gpuSimulation->step(1);
+            states.push_back(gpuSimulation->getCells());
+        }
+    }
+    else
+    {
+        CpuWorld world;
+        world.resize(testCase.grid.width, testCase.grid.height);
+        world.cells = testCase.cells;
+        cpuEngine->setRules(testCase.rules);
+        cpuEngine->invalidate();
+        states.push_back(world.cells);
+        for (int i = 0; i < config.generations; ++i)
+        {
+            cpuEngine->step(world);
+            states.push_back(world.cells);
+        }
+    }
+}
+
+static std::unique_ptr<Simulation> createGpuSimulation(const ConformanceGrid& grid, std::unique_ptr<Texture2D>& textureA, std::unique_ptr<Texture2D>& textureB)
+{
+    textureA = std::make_unique<Texture2D>(grid.width, grid.height);
+    textureB = std::make_unique<Texture2D>(grid.width, grid.height);
+    return std::make_unique<Simulation>(grid.width, grid.height, *textureA, *textureB);
+}
+
+bool Conformance::generateGolden(const ConformanceConfig& config, const std::filesystem::path& goldenPath)
+{
+    std::ofstream file(goldenPath);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open golden file for writing: " << goldenPath.string() << std::endl;
+        return false;
+    }
+    file << getHeader(config) << '\n';
+    file << std::hex;
+
+    std::vector<std::vector<uint8_t>> states;
+    for (const ConformanceGrid& grid : config.grids)
+    {
+        // The compute shader is the reference implementation
+        std::unique_ptr<Texture2D> textureA;
+        std::unique_ptr<Texture2D> textureB;
+        std::unique_ptr<Simulation> gpuSimulation = createGpuSimulation(grid, textureA, textureB);
+
+        for (int range : config.neighborSearchRanges)
+        {
+            for (KernelGenerationType kernelType : config.kernelTypes)
+            {
+                ConformanceCase testCase = createCase(config, grid, range, kernelType);
+                runEngine(config, testCase, gpuSimulation.get(), nullptr, states);
+
+                file << std::dec << grid.width << '\t' << grid.height << '\t' << range << '\t' << (int)kernelType << '\t'
+                    << std::hex << testCase.rules.getHash() << '\t';
+                for (size_t i = 0; i < states.size(); ++i)
+                {
+                    file << (i > 0 ? " " : "") << hashCells(grid.width, grid.height, states[i]);
+                }
+                file << '\n';
+            }
+        }
+    }
+
+    std::cout << "Conformance golden hashes written to " << goldenPath.string() << std::endl;
+    return true;
+}
+
+static bool loadGolden(const ConformanceConfig& config, const std::filesystem::path& goldenPath, std::map<GoldenKey, GoldenCase>& golden)
+{
+    std::ifstream file(goldenPath);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open golden file: " << goldenPath.string() << std::endl;
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(file, line) || line != getHeader(config))
+    {
+        std::cerr << "Golden file was generated with a different configuration: " << goldenPath.string() << std::endl;
+        return false;
+    }
+
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        int width = 0;
+        int height = 0;
+        int range = 0;
+        int kernelType = 0;
+        GoldenCase goldenCase;
+        fields >> std::dec >> width >> height >> range >> kernelType >> std::hex >> goldenCase.rulesHash;
+
+        uint64_t hash = 0;
+        while (fields >> hash)
+        {
+            goldenCase.hashes.push_back(hash);
+        }
+        golden[{ width, height, range, kernelType }] = std::move(goldenCase);
+    }
+    return true;
+}
+
+bool Conformance::run(const ConformanceConfig& config, const std::filesystem::path& goldenPath)
+{
+    std::map<GoldenKey, GoldenCase> golden;
+    if (!loadGolden(config, goldenPath, golden))
+    {
+        return false;
+    }
+
+    bool isGpuTested = false;
+    std::vector<std::unique_ptr<CpuEngine>> cpuEngines;
+    for (EngineType type : config.engines)
+    {
+        if (type == EngineType::GpuCompute)
+        {
+            isGpuTested = true;
+        }
+        else if (std::unique_ptr<CpuEngine> engine = CpuEngine::create(type))
+        {
+            cpuEngines.push_back(std::move(engine));
+        }
+    }
+
+    int failedCount = 0;
+    int skippedCount = 0;
+    int passedCount = 0;
+    for (const ConformanceGrid& grid : config.grids)
+    {
+        std::unique_ptr<Texture2D> textureA;
+        std::unique_ptr<Texture2D> textureB;
+        std::unique_ptr<Simulation> gpuSimulation;
+        if (isGpuTested)
+        {
+            gpuSimulation = createGpuSimulation(grid, textureA, textureB);
+        }
+
+        for (int range : config.neighborSearchRanges)
+        {
+            for (KernelGenerationType kernelType : config.kernelTypes)
+            {
+                ConformanceCase testCase = createCase(config, grid, range, kernelType);
+                std::string caseName = getCaseName(testCase);
+
+                auto goldenIt = golden.find({ grid.width, grid.height, range, (int)kernelType });
+                if (goldenIt == golden.end() || goldenIt->second.hashes.size() != (size_t)config.generations + 1)
+                {
+                    std::cout << caseName << ": FAILED, no golden hashes" << std::endl;
+                    failedCount++;
+                    continue;
+                }
+
+                // Kernels are generated with std distributions, which differ between standard libraries
+                const GoldenCase& goldenCase = goldenIt->second;
+                if (goldenCase.rulesHash != testCase.rules.getHash())
+                {
+                    std::cout << caseName << ": skipped, the rules differ from the golden file" << std::endl;
+                    skippedCount++;
+                    continue;
+                }
+
+                // Every engine is run first, a conforming one is then the reference for locating differing cells
+                std::vector<EngineType> engineTypes;
+                std::vector<std::vector<std::vector<uint8_t>>> engineStates;
+                std::vector<int> firstDifferences;
+                int referenceIndex = -1;
+                for (EngineType engineType : config.engines)
+                {
+                    Simulation* simulation = engineType == EngineType::GpuCompute ? gpuSimulation.get() : nullptr;
+                    auto engineIt = std::find_if(cpuEngines.begin(), cpuEngines.end(), [engineType](const auto& e) { return e->getType() == engineType; });
+                    CpuEngine* engine = engineIt != cpuEngines.end() ? engineIt->get() : nullptr;
+                    if (!simulation && (!engine || !engine->supports(testCase.rules)))
+                    {
+                        continue;
+                    }
+
+                    ScopedTraceEvent trace("Conformance case", "conformance", std::string(ENGINE_TYPE_NAMES[(int)engineType]) + " " + caseName);
+                    std::vector<std::vector<uint8_t>> states;
+                    runEngine(config, testCase, simulation, engine, states);
+
+                    int firstDifference = -1;
+                    for (size_t i = 0; i < states.size(); ++i)
+                    {
+                        if (hashCells(grid.width, grid.height, states[i]) != goldenCase.hashes[i])
+                        {
+                            firstDifference = (int)i;
+                            break;
+                        }
+                    }
+                    if (firstDifference < 0 && (referenceIndex < 0 || engineType == EngineType::GpuCompute))
+                    {
+                        referenceIndex = (int)engineTypes.size();
+                    }
+
+                    engineTypes.push_back(engineType);
+                    engineStates.push_back(std::move(states));
+                    firstDifferences.push_back(firstDifference);
+                }
+
+                for (size_t i = 0; i < engineTypes.size(); ++i)
+                {
+                    std::cout << caseName << ", " << ENGINE_TYPE_NAMES[(int)engineTypes[i]] << ": ";
+                    int generation = firstDifferences[i];
+                    if (generation < 0)
+                    {
+                        std::cout << "ok" << std::endl;
+                        passedCount++;
+                        continue;
+                    }
+
+                    failedCount++;
+                    std::cout << "FAILED at generation " << generation;
+                    if (referenceIndex < 0)
+                    {
+                        std::cout << ", no conforming engine to compare cells with" << std::endl;
+                        continue;
+                    }
+
+                    const std::vector<uint8_t>& expected = engineStates[referenceIndex][generation];
+                    const std::vector<uint8_t>& actual = engineStates[i][generation];
+                    int differingCount = 0;
+                    int firstCell = -1;
+                    for (size_t cell = 0; cell < expected.size(); ++cell)
+                    {
+                        if (expected[cell] != actual[cell])
+                        {
+                            firstCell = firstCell < 0 ? (int)cell : firstCell;
+                            differingCount++;
+                        }
+                    }
+                    if (firstCell >= 0)
+                    {
+                        std::cout << ", first differing cell (" << firstCell % grid.width << ", " << firstCell / grid.width
+                            << "): expected " << (int)expected[firstCell] << ", got " << (int)actual[firstCell]
+                            << ", " << differingCount << " cells differ";
+                    }
+                    std::cout << std::endl;
+                }
+            }
+        }
+    }
+
+    std::cout << "Conformance: " << passedCount << " passed, " << failedCount << " failed, " << skippedCount << " skipped" << std::endl;
+    return failedCount == 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <filesystem>
+#include <vector>
+#include "CpuEngine.h"
+#include "Simulation.h"
+
+struct ConformanceGrid
+{
+    int width = 0;
+    int height = 0;
+};
+
+struct ConformanceConfig
+{
+    // Sizes that are not multiples of the work group size, so partial groups and wrapping are covered;
+    // the small one is narrower than most neighbor ranges, so taps wrap around the world more than once
+    std::vector<ConformanceGrid> grids = { { 100, 75 }, { 7, 5 } };
+    std::vector<int> neighborSearchRanges = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    std::vector<KernelGenerationType> kernelTypes;
+    std::vector<EngineType> engines;
+
+    int generations = 32;
+    float density = 0.3f;
+    unsigned int seed = 2024;
+
+    ConformanceConfig(); // All kernel types and all engines
+};
+
+// Conformance class for checking that every engine produces the same generations as Shaders/automata.comp.
+// Each case steps a seeded world and hashes every generation, the hashes are compared to a golden file
+// generated once from the compute shader. The first differing generation and cell are reported.
+class Conformance
+{
+public:
+    Conformance() = delete;
+
+    // Both need a current OpenGL context
+    static bool generateGolden(const ConformanceConfig& config, const std::filesystem::path& goldenPath);
+    static bool run(const ConformanceConfig& config, const std::filesystem::path& goldenPath);
+
+    // FNV-1a over the size and the cells
+    static uint64_t hashCells(int width, int height, const std::vector<uint8_t>& cells);
+};
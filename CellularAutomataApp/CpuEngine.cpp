@@ -0,0 +1,66 @@
+#include "CpuEngine.h"
+#include "ScalarCpuEngine.h"
+#include "FixedPointCpuEngine.h"
+#include "RadialCpuEngine.h"
+#include "SlidingWindowCpuEngine.h"
+#include "BlockLookupCpuEngine.h"
+#include "ChangeListCpuEngine.h"
+#include "InPlaceCpuEngine.h"
+
+void CpuWorld::resize(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+    cells.assign((size_t)width * height, 0);
+    scratch.clear();
+}
+
+uint8_t* CpuWorld::getScratch()
+{
+    scratch.resize(cells.size());
+    return scratch.data();
+}
+
+void CpuWorld::releaseScratch()
+{
+    scratch.clear();
+    scratch.shrink_to_fit();
+}
+
+void CpuWorld::swapBuffers()
+{
+    cells.swap(scratch);
+}
+
+std::unique_ptr<CpuEngine> CpuEngine::create(EngineType type)
+{
+    switch (type)
+    {
+        case EngineType::ScalarCpu: return std::make_unique<ScalarCpuEngine>();
+        case EngineType::FixedPointCpu: return std::make_unique<FixedPointCpuEngine>();
+        case EngineType::RadialCpu: return std::make_unique<RadialCpuEngine>();
+        case EngineType::SlidingWindowCpu: return std::make_unique<SlidingWindowCpuEngine>();
+        case EngineType::BlockLookupCpu: return std::make_unique<BlockLookupCpuEngine>();
+        case EngineType::ChangeListCpu: return std::make_unique<ChangeListCpuEngine>();
+        case EngineType::InPlaceCpu: return std::make_unique<InPlaceCpuEngine>();
+        default: return nullptr;
+    }
+}
+
+bool CpuEngine::supports(const SimulationRules&) const
+{
+    return true;
+}
+
+void CpuEngine::invalidate()
+{
+}
+
+void TransitionRanges::set(const SimulationRules& rules)
+{
+    // The shader compares the float sum against unsigned ranges converted to float
+    stableMin = (float)(unsigned int)rules.stableRange[0];
+    stableMax = (float)(unsigned int)rules.stableRange[1];
+    birthMin = (float)(unsigned int)rules.birthRange[0];
+    birthMax = (float)(unsigned int)rules.birthRange[1];
+}
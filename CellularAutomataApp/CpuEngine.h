@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "SimulationRules.h"
+
+enum class EngineType : int
+{
+    GpuCompute = 0,
+    ScalarCpu,
+    FixedPointCpu,
+    RadialCpu,
+    SlidingWindowCpu,
+    BlockLookupCpu,
+    ChangeListCpu,
+    InPlaceCpu,
+    COUNT_ // Not an actual engine, just a count of engines
+};
+
+static const char* ENGINE_TYPE_NAMES[] =
+{
+    "GPU compute shader",
+    "Scalar CPU",
+    "Fixed-point CPU",
+    "Radial rings CPU",
+    "Sliding window CPU",
+    "Block lookup CPU",
+    "Change list CPU",
+    "In-place CPU"
+};
+
+// World state for the CPU engines, one byte per cell in the same row-major layout as the GPU textures
+struct CpuWorld
+{
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> cells;
+    std::vector<uint8_t> scratch; // Next generation for engines that do not update in place, allocated on first use
+
+    void resize(int width, int height);
+    uint8_t* getScratch();
+    void releaseScratch();
+    void swapBuffers();
+};
+
+// CpuEngine class, the interface of all engines that step the world on the CPU.
+// Every engine has to produce exactly the same generations as Shaders/automata.comp on a torus.
+class CpuEngine
+{
+public:
+    virtual ~CpuEngine() = default;
+
+    static std::unique_ptr<CpuEngine> create(EngineType type);
+
+    virtual EngineType getType() const = 0;
+    virtual bool supports(const SimulationRules& rules) const;
+    virtual void setRules(const SimulationRules& rules) = 0;
+    virtual void step(CpuWorld& world) = 0;
+
+    // Called when the cells were changed outside of step(), for engines that keep state between generations
+    virtual void invalidate();
+};
+
+// Compiled transition thresholds, compared the same way as the float sum in the compute shader
+struct TransitionRanges
+{
+    float stableMin = 0.0f;
+    float stableMax = 0.0f;
+    float birthMin = 0.0f;
+    float birthMax = 0.0f;
+
+    void set(const SimulationRules& rules);
+
+    uint8_t apply(uint8_t cell, float neighborsSum) const
+    {
+        if (neighborsSum >= birthMin && neighborsSum <= birthMax)
+        {
+            return 1;
+        }
+        if (neighborsSum >= stableMin && neighborsSum <= stableMax)
+        {
+            return cell;
+        }
+        return 0;
+    }
+};
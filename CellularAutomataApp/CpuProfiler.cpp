@@ -0,0 +1,104 @@
+#include "CpuProfiler.h"
+#include <chrono>
+#include "TraceRecorder.h"
+
+struct RingSlot
+{
+    std::atomic<uint64_t> sequence{ 0 }; // index + 1 of the event stored in the slot, 0 while it is written
+    CpuZoneEvent event;
+};
+
+static RingSlot ring[CpuProfiler::RING_CAPACITY];
+static std::atomic<uint64_t> writeIndex{ 0 };
+static std::atomic<uint64_t> frameIndex{ 0 };
+static std::atomic<int> threadsCount{ 0 };
+static std::atomic<int> frameThreadIndex{ 0 };
+
+static thread_local int zoneDepth = 0;
+
+int64_t CpuProfiler::now()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void CpuProfiler::beginFrame()
+{
+    frameThreadIndex.store(getThreadIndex(), std::memory_order_relaxed);
+    frameIndex.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t CpuProfiler::getFrameIndex()
+{
+    return frameIndex.load(std::memory_order_relaxed);
+}
+
+int CpuProfiler::getThreadIndex()
+{
+    static thread_local int threadIndex = threadsCount.fetch_add(1, std::memory_order_relaxed);
+    return threadIndex;
+}
+
+int CpuProfiler::getFrameThreadIndex()
+{
+    return frameThreadIndex.load(std::memory_order_relaxed);
+}
+
+void CpuProfiler::record(const CpuZoneEvent& event)
+{
+    uint64_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+    RingSlot& slot = ring[index & (RING_CAPACITY - 1)];
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = event;
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+void CpuProfiler::getEvents(uint64_t firstFrame, std::vector<CpuZoneEvent>& events)
+{
+    events.clear();
+
+    // Walk backwards from the newest event until the requested frame range is left
+    uint64_t end = writeIndex.load(std::memory_order_acquire);
+    uint64_t begin = end > RING_CAPACITY ? end - RING_CAPACITY : 0;
+    for (uint64_t index = end; index > begin; --index)
+    {
+        const RingSlot& slot = ring[(index - 1) & (RING_CAPACITY - 1)];
+
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        CpuZoneEvent event = slot.event;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence != index || slot.sequence.load(std::memory_order_relaxed) != sequence)
+        {
+            continue; // Still being written or already overwritten
+        }
+
+        if (event.frame < firstFrame)
+        {
+            break;
+        }
+        events.push_back(event);
+    }
+}
+
+ScopedCpuZone::ScopedCpuZone(CpuZone zone)
+    : zone(zone), depth(zoneDepth++), startNs(CpuProfiler::now())
+{
+}
+
+ScopedCpuZone::~ScopedCpuZone()
+{
+    zoneDepth--;
+
+    CpuZoneEvent event;
+    event.zone = zone;
+    event.depth = depth;
+    event.thread = CpuProfiler::getThreadIndex();
+    event.frame = CpuProfiler::getFrameIndex();
+    event.startNs = startNs;
+    event.endNs = CpuProfiler::now();
+    CpuProfiler::record(event);
+
+    TraceRecorder::addCpuEvent(CPU_ZONE_NAMES[static_cast<int>(zone)], "cpu", event.startNs, event.endNs);
+}
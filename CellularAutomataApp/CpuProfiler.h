@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+enum class CpuZone : int
+{
+    Frame = 0,
+    SimulationUpdate,
+    Readback,
+    CellsDraw,
+    UIBuild,
+    KernelDrawList,
+    RulesUpload,
+    ImGuiRender,
+    SwapBuffers,
+    PollEvents,
+    COUNT_ // Not an actual zone, just a count of zones
+};
+
+static const char* CPU_ZONE_NAMES[] =
+{
+    "Frame",
+    "Simulation update",
+    "Readback",
+    "Cells draw",
+    "UI build",
+    "Kernel draw list",
+    "Rules upload",
+    "ImGui render",
+    "Swap buffers",
+    "Poll events"
+};
+
+struct CpuZoneEvent
+{
+    CpuZone zone = CpuZone::Frame;
+    int depth = 0; // Nesting on the recording thread
+    int thread = 0; // See CpuProfiler::getThreadIndex()
+    uint64_t frame = 0; // Current when the zone ended
+    int64_t startNs = 0;
+    int64_t endNs = 0;
+};
+
+// CpuProfiler class for recording scoped CPU timing zones.
+// Finished zones are written into a fixed-size lock-free ring buffer; every slot carries a sequence
+// number, so readers can take a snapshot while other threads keep recording and skip torn slots.
+// Frames are counted by the thread that calls beginFrame(); zones of other threads, e.g. the simulation
+// thread, carry the frame that was current when they ended and are told apart by their thread index.
+class CpuProfiler
+{
+public:
+    static const int RING_CAPACITY = 1 << 14;
+
+    CpuProfiler() = delete;
+
+    static int64_t now();
+    static void beginFrame();
+    static uint64_t getFrameIndex();
+    static int getThreadIndex();      // Of the calling thread, numbered in the order threads first ask
+    static int getFrameThreadIndex(); // Of the thread that called beginFrame()
+
+    static void record(const CpuZoneEvent& event);
+    static void getEvents(uint64_t firstFrame, std::vector<CpuZoneEvent>& events);
+};
+
+// ScopedCpuZone class for measuring the enclosing scope
+class ScopedCpuZone
+{
+public:
+    explicit ScopedCpuZone(CpuZone zone);
+    ~ScopedCpuZone();
+    ScopedCpuZone(const ScopedCpuZone&) = delete;
+    ScopedCpuZone& operator=(const ScopedCpuZone&) = delete;
+private:
+    CpuZone zone;
+    int depth;
+    int64_t startNs;
+};
@@ -0,0 +1,348 @@
+#include "EngineCostModel.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include "Benchmark.h"
+#include "Random.h"
+#include "Simulation.h"
+#include "ThreadPool.h"
+
+const int CPU_CALIBRATION_SIZE = 256;
+const int GPU_CALIBRATION_SIZE = 512;
+const double CALIBRATION_SECONDS_PER_SAMPLE = 0.02;
+const int CALIBRATION_RANGES[] = { 1, 3, 6, 10 };
+const KernelGenerationType CALIBRATION_KERNELS[] = {
+    KernelGenerationType::RandomAllValues,
+    KernelGenerationType::VonNeumann,
+    KernelGenerationType::FilledCircle,
+    KernelGenerationType::Checkerboard
+};
+const double CALIBRATION_ACTIVITY = 0.1;
+
+static std::vector<uint8_t> createCalibrationCells(int size)
+{
+    std::mt19937 engine(4242);
+    std::bernoulli_distribution distribution(0.3);
+    std::vector<uint8_t> cells((size_t)size * size);
+    for (uint8_t& cell : cells)
+    {
+        cell = distribution(engine) ? 1 : 0;
+    }
+    return cells;
+}
+
+double EngineCostModel::estimateWork(EngineType type, const KernelFeatures& features, double activity)
+{
+    switch (type)
+    {
+        case EngineType::GpuCompute: return features.nonZeroTaps;
+        case EngineType::ScalarCpu: return features.nonZeroTaps;
+        case EngineType::FixedPointCpu: return features.nonZeroTaps;
+        case EngineType::SlidingWindowCpu: return features.rowRuns;
+        case EngineType::BlockLookupCpu: return 1.0; // One lookup per four cells, whatever the kernel
+        case EngineType::InPlaceCpu: return features.nonZeroTaps;
+        case EngineType::ChangeListCpu: return std::min(activity * 2.0, 1.0) * features.nonZeroTaps; // Dense above the changed fraction limit
+        case EngineType::RadialCpu: return features.radialRuns + features.neighborSearchRange * 2 + 1;
+        default: return features.denseTaps;
+    }
+}
+
+bool EngineCostModel::loadOrCalibrate(const std::filesystem::path& path)
+{
+    if (load(path))
+    {
+        return true;
+    }
+
+    std::cout << "Calibrating engine cost model..." << std::endl;
+    calibrate();
+    return save(path);
+}
+
+bool EngineCostModel::load(const std::filesystem::path& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(file, line) || line != "fingerprint\t" + getFingerprint())
+    {
+        std::cout << "Engine cost model was calibrated on a different machine" << std::endl;
+        return false;
+    }
+
+    EngineCost loadedCosts[static_cast<int>(EngineType::COUNT_)];
+    double loadedUploadSecondsPerCell = 0.0;
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        std::string name;
+        std::getline(fields, name, '\t');
+
+        if (name == "upload")
+        {
+            fields >> loadedUploadSecondsPerCell;
+            continue;
+        }
+
+        for (int i = 0; i < static_cast<int>(EngineType::COUNT_); ++i)
+        {
+            if (name == ENGINE_TYPE_NAMES[i])
+            {
+                fields >> loadedCosts[i].secondsPerCell >> loadedCosts[i].secondsPerCellWork;
+                loadedCosts[i].isCalibrated = !fields.fail();
+            }
+        }
+    }
+
+    // An engine added since the last calibration needs a new one
+    for (const EngineCost& cost : loadedCosts)
+    {
+        if (!cost.isCalibrated)
+        {
+            return false;
+        }
+    }
+
+    std::copy(std::begin(loadedCosts), std::end(loadedCosts), std::begin(costs));
+    uploadSecondsPerCell = loadedUploadSecondsPerCell;
+    hasCalibration = true;
+    return true;
+}
+
+bool EngineCostModel::save(const std::filesystem::path& path) const
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open engine cost file for writing: " << path.string() << std::endl;
+        return false;
+    }
+
+    file.precision(9);
+    file << "fingerprint\t" << getFingerprint() << '\n';
+    file << "upload\t" << uploadSecondsPerCell << '\n';
+    for (int i = 0; i < static_cast<int>(EngineType::COUNT_); ++i)
+    {
+        file << ENGINE_TYPE_NAMES[i] << '\t' << costs[i].secondsPerCell << '\t' << costs[i].secondsPerCellWork << '\n';
+    }
+    return true;
+}
+
+void EngineCostModel::calibrate()
+{
+    std::vector<uint8_t> cpuCells = createCalibrationCells(CPU_CALIBRATION_SIZE);
+    std::vector<uint8_t> gpuCells = createCalibrationCells(GPU_CALIBRATION_SIZE);
+
+    Texture2D textureA(GPU_CALIBRATION_SIZE, GPU_CALIBRATION_SIZE);
+    Texture2D textureB(GPU_CALIBRATION_SIZE, GPU_CALIBRATION_SIZE);
+    Simulation gpuSimulation(GPU_CALIBRATION_SIZE, GPU_CALIBRATION_SIZE, textureA, textureB);
+
+    for (int type = 0; type < static_cast<int>(EngineType::COUNT_); ++type)
+    {
+        EngineType engineType = static_cast<EngineType>(type);
+        std::unique_ptr<CpuEngine> engine = CpuEngine::create(engineType);
+        CpuWorld world;
+        world.resize(CPU_CALIBRATION_SIZE, CPU_CALIBRATION_SIZE);
+
+        // Samples of (work per cell, seconds per cell)
+        std::vector<std::pair<double, double>> samples;
+        for (int range : CALIBRATION_RANGES)
+        {
+            for (KernelGenerationType kernelType : CALIBRATION_KERNELS)
+            {
+                Random::Seed(range * 31 + (int)kernelType);
+                SimulationRules rules = SimulationRules::createTestRules(range, kernelType);
+                KernelFeatures features = KernelFeatures::compute(rules);
+
+                BenchmarkResult result;
+                double cellsCount = 0.0;
+                if (engineType == EngineType::GpuCompute)
+                {
+                    gpuSimulation.rules = rules;
+                    gpuSimulation.submitRulesToShader();
+                    gpuSimulation.setCells(gpuCells);
+                    result = Benchmark::measure(CALIBRATION_SECONDS_PER_SAMPLE, 1000, [&](int generations)
+                        {
+                            gpuSimulation.step(generations);
+                            glFinish();
+                        });
+                    cellsCount = (double)GPU_CALIBRATION_SIZE * GPU_CALIBRATION_SIZE;
+                }
+                else if (engine && engine->supports(rules))
+                {
+                    engine->setRules(rules);
+                    world.cells = cpuCells;
+                    engine->invalidate();
+                    result = Benchmark::measure(CALIBRATION_SECONDS_PER_SAMPLE, 1000, [&](int generations)
+                        {
+                            for (int i = 0; i < generations; ++i)
+                            {
+                                engine->step(world);
+                            }
+                        });
+                    cellsCount = (double)CPU_CALIBRATION_SIZE * CPU_CALIBRATION_SIZE;
+                }
+
+                if (result.generations > 0)
+                {
+                    double work = estimateWork(engineType, features, CALIBRATION_ACTIVITY);
+                    samples.emplace_back(work, result.seconds / result.generations / cellsCount);
+                }
+            }
+        }
+
+        // Least squares fit of seconds per cell = a + b * work
+        EngineCost& cost = costs[type];
+        cost.isCalibrated = !samples.empty();
+        if (samples.empty())
+        {
+            continue;
+        }
+
+        double meanWork = 0.0;
+        double meanSeconds = 0.0;
+        for (const auto& sample : samples)
+        {
+            meanWork += sample.first;
+            meanSeconds += sample.second;
+        }
+        meanWork /= samples.size();
+        meanSeconds /= samples.size();
+
+        double covariance = 0.0;
+        double variance = 0.0;
+        for (const auto& sample : samples)
+        {
+            covariance += (sample.first - meanWork) * (sample.second - meanSeconds);
+            variance += (sample.first - meanWork) * (sample.first - meanWork);
+        }
+        cost.secondsPerCellWork = variance > 0.0 ? std::max(covariance / variance, 0.0) : 0.0;
+        cost.secondsPerCell = std::max(meanSeconds - cost.secondsPerCellWork * meanWork, 0.0);
+    }
+
+    // Cost of showing a CPU generation: one texture upload
+    std::vector<uint8_t> uploadCells = gpuCells;
+    BenchmarkResult upload = Benchmark::measure(CALIBRATION_SECONDS_PER_SAMPLE, 1000, [&](int count)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                textureA.setData(uploadCells.data());
+            }
+            glFinish();
+        });
+    uploadSecondsPerCell = upload.seconds / upload.generations / ((double)GPU_CALIBRATION_SIZE * GPU_CALIBRATION_SIZE);
+
+    hasCalibration = true;
+    Random::Seed(std::random_device()());
+}
+
+bool EngineCostModel::isCalibrated() const
+{
+    return hasCalibration;
+}
+
+double EngineCostModel::predictSeconds(EngineType type, const KernelFeatures& features, int cellsCount, double activity) const
+{
+    const EngineCost& cost = costs[static_cast<int>(type)];
+    return cellsCount * (cost.secondsPerCell + cost.secondsPerCellWork * estimateWork(type, features, activity));
+}
+
+EngineSelection EngineCostModel::select(
+    const SimulationRules& rules,
+    const std::vector<std::unique_ptr<CpuEngine>>& cpuEngines,
+    int gridW,
+    int gridH,
+    double activity,
+    double generationsPerUpload
+) const
+{
+    EngineSelection best;
+    if (!hasCalibration)
+    {
+        best.reason = "cost model is not calibrated";
+        return best;
+    }
+
+    KernelFeatures features = KernelFeatures::compute(rules);
+    int cellsCount = gridW * gridH;
+
+    std::vector<EngineSelection> candidates;
+    EngineSelection gpu;
+    gpu.type = EngineType::GpuCompute;
+    gpu.predictedSeconds = predictSeconds(EngineType::GpuCompute, features, cellsCount, activity);
+    candidates.push_back(gpu);
+
+    for (const auto& engine : cpuEngines)
+    {
+        if (!costs[static_cast<int>(engine->getType())].isCalibrated || !engine->supports(rules))
+        {
+            continue;
+        }
+
+        // CPU generations also have to reach the texture, once per uploaded batch
+        EngineSelection cpu;
+        cpu.type = engine->getType();
+        cpu.predictedSeconds = predictSeconds(cpu.type, features, cellsCount, activity)
+            + uploadSecondsPerCell * cellsCount / std::max(generationsPerUpload, 1.0);
+        candidates.push_back(cpu);
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const EngineSelection& a, const EngineSelection& b) { return a.predictedSeconds < b.predictedSeconds; });
+    best = candidates.front();
+
+    char reason[256];
+    int length = snprintf(reason, sizeof(reason), "%.3f ms/gen predicted; r=%d, %d of %d taps non-zero, rank %d, %s%s weights",
+        best.predictedSeconds * 1000.0,
+        features.neighborSearchRange,
+        features.nonZeroTaps,
+        features.denseTaps,
+        features.rank,
+        features.isUniform ? "uniform " : "",
+        features.isInteger ? "integer" : "fractional");
+    if (candidates.size() > 1 && length > 0 && length < (int)sizeof(reason))
+    {
+        snprintf(reason + length, sizeof(reason) - length, "; next best %s at %.3f ms",
+            ENGINE_TYPE_NAMES[static_cast<int>(candidates[1].type)],
+            candidates[1].predictedSeconds * 1000.0);
+    }
+    best.reason = reason;
+    return best;
+}
+
+EngineType EngineCostModel::selectCpuEngine(const SimulationRules& rules, int cellsCount) const
+{
+    KernelFeatures features = KernelFeatures::compute(rules);
+    EngineType bestEngine = EngineType::COUNT_;
+    double bestSeconds = 0.0;
+    for (int i = 0; i < static_cast<int>(EngineType::COUNT_); ++i)
+    {
+        EngineType type = static_cast<EngineType>(i);
+        std::unique_ptr<CpuEngine> engine = CpuEngine::create(type);
+        if (!engine || !engine->supports(rules))
+        {
+            continue;
+        }
+
+        double seconds = predictSeconds(type, features, cellsCount, 1.0);
+        if (bestEngine == EngineType::COUNT_ || seconds < bestSeconds)
+        {
+            bestEngine = type;
+            bestSeconds = seconds;
+        }
+    }
+    return bestEngine;
+}
+
+std::string EngineCostModel::getFingerprint()
+{
+    const GLubyte* renderer = glGetString(GL_RENDERER);
+    return std::string(renderer ? (const char*)renderer : "unknown") + "; " + std::to_string(ThreadPool::getThreadCount()) + " threads";
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include "CpuEngine.h"
+#include "KernelFeatures.h"
+
+struct EngineSelection
+{
+    EngineType type = EngineType::GpuCompute;
+    double predictedSeconds = 0.0; // Per generation
+    std::string reason;
+};
+
+// EngineCostModel class for predicting the cost of a generation on every engine.
+// Each engine has a cost per cell that grows linearly with an engine-specific amount of work per cell
+// (taps read, ring sums, changed cells...). The two coefficients are fitted by a short micro-benchmark
+// and stored on disk together with a fingerprint of the machine, so calibration runs only once.
+class EngineCostModel
+{
+public:
+    static double estimateWork(EngineType type, const KernelFeatures& features, double activity);
+
+    bool loadOrCalibrate(const std::filesystem::path& path); // Needs a current OpenGL context
+    bool load(const std::filesystem::path& path);
+    bool save(const std::filesystem::path& path) const;
+    void calibrate();
+    bool isCalibrated() const;
+
+    double predictSeconds(EngineType type, const KernelFeatures& features, int cellsCount, double activity) const;
+    EngineSelection select(
+        const SimulationRules& rules,
+        const std::vector<std::unique_ptr<CpuEngine>>& cpuEngines,
+        int gridW,
+        int gridH,
+        double activity,
+        double generationsPerUpload
+    ) const;
+
+    // Fastest CPU engine for worlds stepped piecewise without a texture, COUNT_ when none supports the rules.
+    // Without a calibration the first supporting engine is returned.
+    EngineType selectCpuEngine(const SimulationRules& rules, int cellsCount) const;
+private:
+    struct EngineCost
+    {
+        bool isCalibrated = false;
+        double secondsPerCell = 0.0;
+        double secondsPerCellWork = 0.0;
+    };
+
+    EngineCost costs[static_cast<int>(EngineType::COUNT_)];
+    double uploadSecondsPerCell = 0.0;
+    bool hasCalibration = false;
+
+    static std::string getFingerprint();
+};
@@ -0,0 +1,140 @@
+#include "FixedBlockPool.h"
+#include <algorithm>
+#include <new>
+#include "PageAllocator.h"
+
+const size_t THREAD_CACHE_BATCH = 32;
+
+FixedBlockPool::FixedBlockPool(size_t blockBytes)
+    : blockBytes((blockBytes + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT)
+{
+    blocksPerSlab = std::max<size_t>(PageAllocator::HUGE_PAGE_BYTES / this->blockBytes, 1);
+    slabBytes = PageAllocator::roundUp(blocksPerSlab * this->blockBytes);
+}
+
+FixedBlockPool::~FixedBlockPool()
+{
+    for (void* slab : slabs)
+    {
+        PageAllocator::deallocate(slab);
+    }
+}
+
+void FixedBlockPool::addSlab()
+{
+    bool isHugePages = false;
+    uint8_t* data = static_cast<uint8_t*>(PageAllocator::allocate(slabBytes, isHugePages));
+    if (!data)
+    {
+        throw std::bad_alloc();
+    }
+    slabs.push_back(data);
+    hasHugePages = hasHugePages && isHugePages;
+
+    // Pushed in reverse, so blocks of a new slab are handed out in address order
+    for (size_t i = blocksPerSlab; i-- > 0;)
+    {
+        freeBlocks.push_back(data + i * blockBytes);
+    }
+}
+
+void* FixedBlockPool::allocate()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (freeBlocks.empty())
+    {
+        addSlab();
+    }
+
+    void* block = freeBlocks.back();
+    freeBlocks.pop_back();
+    return block;
+}
+
+void FixedBlockPool::deallocate(void* block)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    freeBlocks.push_back(block);
+}
+
+void FixedBlockPool::allocateBatch(std::vector<void*>& blocks, size_t count)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    while (freeBlocks.size() < count)
+    {
+        addSlab();
+    }
+    blocks.insert(blocks.end(), freeBlocks.end() - count, freeBlocks.end());
+    freeBlocks.resize(freeBlocks.size() - count);
+}
+
+void FixedBlockPool::deallocateBatch(std::vector<void*>& blocks, size_t count)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    freeBlocks.insert(freeBlocks.end(), blocks.end() - count, blocks.end());
+    blocks.resize(blocks.size() - count);
+}
+
+size_t FixedBlockPool::getBlockBytes() const
+{
+    return blockBytes;
+}
+
+size_t FixedBlockPool::getAllocatedBlocks() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return slabs.size() * blocksPerSlab - freeBlocks.size();
+}
+
+size_t FixedBlockPool::getCapacityBlocks() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return slabs.size() * blocksPerSlab;
+}
+
+bool FixedBlockPool::isUsingHugePages() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return !slabs.empty() && hasHugePages;
+}
+
+FixedBlockPool::ThreadCache::ThreadCache(FixedBlockPool& pool)
+    : pool(&pool)
+{
+}
+
+FixedBlockPool::ThreadCache::~ThreadCache()
+{
+    if (pool && !blocks.empty())
+    {
+        pool->deallocateBatch(blocks, blocks.size());
+    }
+}
+
+FixedBlockPool::ThreadCache::ThreadCache(ThreadCache&& other) noexcept
+    : pool(other.pool), blocks(std::move(other.blocks))
+{
+    other.pool = nullptr;
+}
+
+void* FixedBlockPool::ThreadCache::allocate()
+{
+    if (blocks.empty())
+    {
+        pool->allocateBatch(blocks, THREAD_CACHE_BATCH);
+    }
+
+    void* block = blocks.back();
+    blocks.pop_back();
+    return block;
+}
+
+void FixedBlockPool::ThreadCache::deallocate(void* block)
+{
+    // Half of a full cache goes back, so alternating allocations and frees do not hit the pool every time
+    blocks.push_back(block);
+    if (blocks.size() >= THREAD_CACHE_BATCH * 2)
+    {
+        pool->deallocateBatch(blocks, THREAD_CACHE_BATCH);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// FixedBlockPool class for allocating many blocks of one size without a heap allocation per block.
+// Blocks are carved from slabs of whole huge pages (see PageAllocator) and returned to a free list.
+// Slabs are only released together with the pool, so the pool never fragments: its size is the peak
+// number of blocks in use. The pool is thread-safe; threads that allocate often use a ThreadCache,
+// which moves blocks to and from the shared free list in batches.
+class FixedBlockPool
+{
+public:
+    static const size_t BLOCK_ALIGNMENT = 64; // Blocks of different threads never share a cache line
+
+    // Free list of one thread, returns its blocks to the pool when destroyed
+    class ThreadCache
+    {
+    public:
+        explicit ThreadCache(FixedBlockPool& pool);
+        ~ThreadCache();
+        ThreadCache(const ThreadCache&) = delete;
+        ThreadCache& operator=(const ThreadCache&) = delete;
+        ThreadCache(ThreadCache&& other) noexcept;
+        ThreadCache& operator=(ThreadCache&&) = delete;
+
+        void* allocate();
+        void deallocate(void* block);
+    private:
+        FixedBlockPool* pool;
+        std::vector<void*> blocks;
+    };
+
+    explicit FixedBlockPool(size_t blockBytes);
+    ~FixedBlockPool();
+    FixedBlockPool(const FixedBlockPool&) = delete;
+    FixedBlockPool& operator=(const FixedBlockPool&) = delete;
+
+    void* allocate();
+    void deallocate(void* block);
+
+    size_t getBlockBytes() const;
+    size_t getAllocatedBlocks() const; // Including the blocks held by thread caches
+    size_t getCapacityBlocks() const;
+    bool isUsingHugePages() const;
+private:
+    size_t blockBytes;
+    size_t blocksPerSlab;
+    size_t slabBytes;
+
+    mutable std::mutex mutex;
+    std::vector<void*> slabs;
+    std::vector<void*> freeBlocks;
+    bool hasHugePages = true;
+
+    void addSlab();
+    void allocateBatch(std::vector<void*>& blocks, size_t count);
+    void deallocateBatch(std::vector<void*>& blocks, size_t count);
+};
@@ -0,0 +1,86 @@
+#include "FixedPointCpuEngine.h"
+#include <algorithm>
+#include "ThreadPool.h"
+
+EngineType FixedPointCpuEngine::getType() const
+{
+    return EngineType::FixedPointCpu;
+}
+
+bool FixedPointCpuEngine::supports(const SimulationRules& rules) const
+{
+    return rules.getFixedPointRules().isValid();
+}
+
+void FixedPointCpuEngine::setRules(const SimulationRules& rules)
+{
+    kernel = SparseKernel::compile(rules);
+}
+
+void FixedPointCpuEngine::step(CpuWorld& world)
+{
+    const int w = world.width;
+    const int h = world.height;
+    const int range = kernel.neighborSearchRange;
+    const int paddedWidth = w + 2 * range;
+
+    const uint8_t* current = world.cells.data();
+    uint8_t* next = world.getScratch();
+
+    // Every row gets range wrapped cells on both sides
+    paddedCells.resize((size_t)paddedWidth * h);
+    ThreadPool::parallelFor(0, h, [&](int rowBegin, int rowEnd)
+        {
+            for (int y = rowBegin; y < rowEnd; ++y)
+            {
+                const uint8_t* source = current + (size_t)y * w;
+                uint8_t* padded = paddedCells.data() + (size_t)y * paddedWidth;
+                for (int i = 0; i < paddedWidth; ++i)
+                {
+                    padded[i] = source[((i - range) % w + w) % w];
+                }
+            }
+        });
+
+    const TransitionTable& transitions = kernel.fixedPoint.transitions;
+
+    ThreadPool::parallelFor(0, h, [&](int rowBegin, int rowEnd)
+        {
+            std::vector<int16_t> sums(w);
+            std::vector<int16_t> counts(w);
+            int16_t* rowSums = sums.data();
+            int16_t* rowCounts = counts.data();
+            for (int y = rowBegin; y < rowEnd; ++y)
+            {
+                std::fill(sums.begin(), sums.end(), 0);
+                for (const KernelTapGroup& group : kernel.groups)
+                {
+                    std::fill(counts.begin(), counts.end(), 0);
+                    for (int i = group.firstTap; i < group.firstTap + group.tapCount; ++i)
+                    {
+                        const KernelTap& tap = kernel.taps[i];
+                        const uint8_t* taps = paddedCells.data() + (size_t)(((y + tap.dy) % h + h) % h) * paddedWidth + tap.dx + range;
+                        for (int x = 0; x < w; ++x)
+                        {
+                            rowCounts[x] += taps[x];
+                        }
+                    }
+
+                    const int16_t weight = (int16_t)group.fixedWeight;
+                    for (int x = 0; x < w; ++x)
+                    {
+                        rowSums[x] += (int16_t)(rowCounts[x] * weight);
+                    }
+                }
+
+                const uint8_t* cells = current + (size_t)y * w;
+                uint8_t* nextCells = next + (size_t)y * w;
+                for (int x = 0; x < w; ++x)
+                {
+                    nextCells[x] = transitions.getNextState(cells[x], sums[x]);
+                }
+            }
+        });
+
+    world.swapBuffers();
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "CpuEngine.h"
+#include "SparseKernel.h"
+
+// FixedPointCpuEngine class for kernels with an exact fixed-point form (see FixedPointRules).
+// Rows are padded with their wrapped cells, then the taps of every weight group are counted into a row of int16
+// counts and multiplied once, in contiguous loops that the compiler turns into int16 SIMD.
+class FixedPointCpuEngine : public CpuEngine
+{
+public:
+    EngineType getType() const override;
+    bool supports(const SimulationRules& rules) const override;
+    void setRules(const SimulationRules& rules) override;
+    void step(CpuWorld& world) override;
+private:
+    SparseKernel kernel;
+    std::vector<uint8_t> paddedCells;
+};
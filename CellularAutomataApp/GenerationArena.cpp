@@ -0,0 +1,65 @@
+#include "GenerationArena.h"
+#include <cstdint>
+#include <new>
+#include "PageAllocator.h"
+
+GenerationArena::~GenerationArena()
+{
+    for (const Block& block : blocks)
+    {
+        PageAllocator::deallocate(block.data);
+    }
+}
+
+void* GenerationArena::allocate(size_t bytes, size_t alignment)
+{
+    // E.g. the lists of an empty world, the page allocator cannot map a block of 0 bytes
+    if (bytes == 0)
+    {
+        return nullptr;
+    }
+
+    while (currentBlock < blocks.size())
+    {
+        const Block& block = blocks[currentBlock];
+        uintptr_t address = (reinterpret_cast<uintptr_t>(block.data) + offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        size_t end = address - reinterpret_cast<uintptr_t>(block.data) + bytes;
+        if (end <= block.bytes)
+        {
+            offset = end;
+            return reinterpret_cast<void*>(address);
+        }
+
+        currentBlock++;
+        offset = 0;
+    }
+
+    // Blocks are page aligned, so a new one fits the request at offset 0
+    bool isHugePages = false;
+    size_t blockBytes = PageAllocator::roundUp(bytes);
+    char* data = static_cast<char*>(PageAllocator::allocate(blockBytes, isHugePages));
+    if (!data)
+    {
+        throw std::bad_alloc();
+    }
+    blocks.push_back({ data, blockBytes });
+    currentBlock = blocks.size() - 1;
+    offset = bytes;
+    return data;
+}
+
+void GenerationArena::reset()
+{
+    currentBlock = 0;
+    offset = 0;
+}
+
+size_t GenerationArena::getCapacityBytes() const
+{
+    size_t bytes = 0;
+    for (const Block& block : blocks)
+    {
+        bytes += block.bytes;
+    }
+    return bytes;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// GenerationArena class, a bump allocator for data that lives for one generation (candidate lists,
+// per-chunk results...). reset() makes all of it free at once but keeps the blocks, so after the first
+// generations stepping allocates nothing and the arena stays as large as the largest generation.
+class GenerationArena
+{
+public:
+    GenerationArena() = default;
+    ~GenerationArena();
+    GenerationArena(const GenerationArena&) = delete;
+    GenerationArena& operator=(const GenerationArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment); // nullptr for 0 bytes
+    void reset();
+
+    // Not constructed, for trivial types
+    template <typename T>
+    T* allocateArray(size_t count)
+    {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    size_t getCapacityBytes() const;
+private:
+    struct Block
+    {
+        char* data;
+        size_t bytes;
+    };
+
+    std::vector<Block> blocks;
+    size_t currentBlock = 0;
+    size_t offset = 0;
+};
@@ -0,0 +1,137 @@
+#include "GpuProfiler.h"
+#include <mutex>
+#include "TraceRecorder.h"
+
+const int ZONES_COUNT = static_cast<int>(GpuZone::COUNT_);
+
+static std::mutex statisticsMutex;
+static RollingStatistics zoneStatistics[ZONES_COUNT];
+static uint64_t zoneLateFrames[ZONES_COUNT] = {};
+
+GpuTimer::GpuTimer(GpuZone zone)
+    : zone(zone)
+{
+}
+
+GpuTimer::~GpuTimer()
+{
+    release();
+}
+
+void GpuTimer::release()
+{
+    for (FrameQueries& frame : frames)
+    {
+        if (!frame.queries.empty())
+        {
+            glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+        }
+        frame.queries.clear();
+        frame.used = 0;
+    }
+}
+
+void GpuTimer::beginFrame()
+{
+    // Queries are only reused once their results were read, until then new ones join the current frame
+    FrameQueries& current = frames[frameIndex];
+    FrameQueries& previous = frames[1 - frameIndex];
+    if (previous.used > 0 && !collect(previous))
+    {
+        if (current.used > 0)
+        {
+            GpuProfiler::addLateFrame(zone);
+        }
+        return;
+    }
+
+    // Frames without queries, e.g. while the simulation is paused, keep the current queries
+    if (current.used > 0)
+    {
+        frameIndex = 1 - frameIndex;
+    }
+}
+
+void GpuTimer::begin()
+{
+    FrameQueries& frame = frames[frameIndex];
+    if (frame.used + 2 > (int)frame.queries.size())
+    {
+        size_t oldSize = frame.queries.size();
+        frame.queries.resize(oldSize + 2);
+        glGenQueries(2, frame.queries.data() + oldSize);
+    }
+    glQueryCounter(frame.queries[frame.used], GL_TIMESTAMP);
+}
+
+void GpuTimer::end()
+{
+    FrameQueries& frame = frames[frameIndex];
+    glQueryCounter(frame.queries[frame.used + 1], GL_TIMESTAMP);
+    frame.used += 2;
+}
+
+double GpuTimer::getLastMilliseconds() const
+{
+    return lastMilliseconds;
+}
+
+bool GpuTimer::collect(FrameQueries& frame)
+{
+    // Timestamps complete in order, so the last query being ready means all of them are
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+    {
+        return false;
+    }
+
+    double totalMilliseconds = 0.0;
+    for (int i = 0; i < frame.used; i += 2)
+    {
+        GLuint64 beginTime = 0;
+        GLuint64 endTime = 0;
+        glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &beginTime);
+        glGetQueryObjectui64v(frame.queries[i + 1], GL_QUERY_RESULT, &endTime);
+        GpuProfiler::addSample(zone, (endTime - beginTime) / 1.0e6);
+        TraceRecorder::addGpuEvent(GPU_ZONE_NAMES[static_cast<int>(zone)], beginTime, endTime);
+        totalMilliseconds += (endTime - beginTime) / 1.0e6;
+    }
+    lastMilliseconds = totalMilliseconds / (frame.used / 2);
+    frame.used = 0;
+    return true;
+}
+
+void GpuProfiler::addSample(GpuZone zone, double milliseconds)
+{
+    std::lock_guard<std::mutex> lock(statisticsMutex);
+    zoneStatistics[static_cast<int>(zone)].add(milliseconds);
+}
+
+void GpuProfiler::addLateFrame(GpuZone zone)
+{
+    std::lock_guard<std::mutex> lock(statisticsMutex);
+    zoneLateFrames[static_cast<int>(zone)]++;
+}
+
+RollingStatistics::Summary GpuProfiler::getStatistics(GpuZone zone)
+{
+    std::lock_guard<std::mutex> lock(statisticsMutex);
+    return zoneStatistics[static_cast<int>(zone)].getSummary();
+}
+
+uint64_t GpuProfiler::getLateFrames(GpuZone zone)
+{
+    std::lock_guard<std::mutex> lock(statisticsMutex);
+    return zoneLateFrames[static_cast<int>(zone)];
+}
+
+void GpuProfiler::reset()
+{
+    std::lock_guard<std::mutex> lock(statisticsMutex);
+    for (int i = 0; i < ZONES_COUNT; ++i)
+    {
+        zoneStatistics[i].clear();
+        zoneLateFrames[i] = 0;
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+#include "RollingStatistics.h"
+
+enum class GpuZone : int
+{
+    SimulationStep = 0,
+    CellsDraw,
+    ImGuiRender,
+    COUNT_ // Not an actual zone, just a count of zones
+};
+
+static const char* GPU_ZONE_NAMES[] =
+{
+    "Simulation step",
+    "Cells draw",
+    "ImGui render"
+};
+
+// GpuTimer class for measuring GPU time of a zone with GL_TIMESTAMP queries.
+// Queries are double-buffered per frame: beginFrame() reads back the queries of the previous frame once
+// the driver reports them available, so measuring never stalls the pipeline. Until then no query is
+// reused and the new ones join the current frame; frames that issued no queries do not advance the buffers.
+// Every begin()/end() pair becomes one sample, e.g. one generation for the simulation step.
+// Query objects are not shared between contexts, so a timer must stay on the thread that created it.
+class GpuTimer
+{
+public:
+    explicit GpuTimer(GpuZone zone);
+    ~GpuTimer();
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void beginFrame();
+    void release(); // Deletes the queries, on the thread that issued them
+    void begin();
+    void end();
+
+    // Mean of the samples read back by the latest beginFrame() that had any, 0 before the first
+    double getLastMilliseconds() const;
+private:
+    struct FrameQueries
+    {
+        std::vector<GLuint> queries;
+        int used = 0;
+    };
+
+    GpuZone zone;
+    FrameQueries frames[2];
+    int frameIndex = 0;
+    double lastMilliseconds = 0.0;
+
+    bool collect(FrameQueries& frame); // False while the results are not available yet
+};
+
+// GpuProfiler class for collecting the samples of all GPU timers
+class GpuProfiler
+{
+public:
+    GpuProfiler() = delete;
+
+    static void addSample(GpuZone zone, double milliseconds);
+    static void addLateFrame(GpuZone zone); // The results of the previous frame were not available yet
+    static RollingStatistics::Summary getStatistics(GpuZone zone);
+    static uint64_t getLateFrames(GpuZone zone);
+    static void reset();
+};
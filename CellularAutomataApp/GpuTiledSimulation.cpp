@@ -0,0 +1,362 @@
+#include "GpuTiledSimulation.h"
+#include <glad/glad.h>
+#include <math.h>
+#include <algorithm>
+#include <iostream>
+#include "Halo.h"
+#include "TraceRecorder.h"
+
+const int WORK_GROUP_W = 8;
+const int WORK_GROUP_H = 8;
+
+// Smallest number of equal tiles of at most maxTileLength cells along one axis, gives the tile length.
+// Tiles shorter than about half of maxTileLength would make the halo copies dominate, 0 is returned then.
+static int chooseTileLength(int length, int maxTileLength)
+{
+    int minTilesCount = (length + maxTileLength - 1) / maxTileLength;
+    for (int tilesCount = minTilesCount; tilesCount <= minTilesCount * 2; ++tilesCount)
+    {
+        if (length % tilesCount == 0)
+        {
+            return length / tilesCount;
+        }
+    }
+    return 0;
+}
+
+static int getMaxTileSize(int maxTileSize)
+{
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    return std::min(maxTileSize, (int)maxTextureSize - 2 * GpuTiledSimulation::MAX_HALO);
+}
+
+bool GpuTiledSimulation::canSplit(int gridW, int gridH, int maxTileSize)
+{
+    maxTileSize = getMaxTileSize(maxTileSize);
+    return chooseTileLength(gridW, maxTileSize) > 0 && chooseTileLength(gridH, maxTileSize) > 0;
+}
+
+GpuTiledSimulation::GpuTiledSimulation(int gridW, int gridH, int maxTileSize)
+    : gridW(gridW), gridH(gridH)
+{
+    maxTileSize = getMaxTileSize(maxTileSize);
+
+    tileW = chooseTileLength(gridW, maxTileSize);
+    tileH = chooseTileLength(gridH, maxTileSize);
+    tilesX = gridW / tileW;
+    tilesY = gridH / tileH;
+    tiles.resize((size_t)tilesX * tilesY);
+    hostPool = std::make_unique<FixedBlockPool>((size_t)tileW * tileH);
+
+    // Tiles are stepped inside their halo, so no cell ever wraps around the texture
+    std::vector<Shader::ShaderSource> sources = {
+        { GL_COMPUTE_SHADER, "Shaders/automata.comp" }
+    };
+    computeShader = std::make_unique<Shader>(sources);
+    computeShader->use();
+    computeShader->setInt("gridWidth", tileW + 2 * MAX_HALO);
+    computeShader->setInt("gridHeight", tileH + 2 * MAX_HALO);
+    computeShader->setIvec2("cellOffset", MAX_HALO, MAX_HALO);
+
+    groupsX = ceilf((float)tileW / (float)WORK_GROUP_W);
+    groupsY = ceilf((float)tileH / (float)WORK_GROUP_H);
+
+    setRules(SimulationRules());
+}
+
+bool GpuTiledSimulation::setRules(const SimulationRules& rules)
+{
+    if (rules.neighborSearchRange > MAX_HALO || rules.neighborSearchRange > std::min(tileW, tileH))
+    {
+        return false;
+    }
+
+    neighborSearchRange = rules.neighborSearchRange;
+    rulesBuffers.submit(rules, *computeShader);
+    return true;
+}
+
+void GpuTiledSimulation::step(int generations)
+{
+    ScopedTraceEvent trace("GPU tiled step", "simulation");
+
+    computeShader->use();
+    rulesBuffers.bind();
+
+    for (int i = 0; i < generations; i++)
+    {
+        int current = getCurrentBuffer();
+        for (int tileIndex = 0; tileIndex < (int)tiles.size(); ++tileIndex)
+        {
+            if (!makeResident(tileIndex))
+            {
+                return;
+            }
+            fillHalo(tileIndex);
+
+            const Slot& slot = slots[tiles[tileIndex].slot];
+            glBindImageTexture(0, slot.textures[current]->getID(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8UI);
+            glBindImageTexture(1, slot.textures[1 - current]->getID(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8UI);
+            glDispatchCompute(groupsX, groupsY, 1);
+            tiles[tileIndex].isStepped = true;
+        }
+
+        // The next generation is read by image loads, copies and downloads
+        glMemoryBarrier(GL_ALL_BARRIER_BITS);
+        for (Tile& tile : tiles)
+        {
+            tile.isStepped = false;
+        }
+        generation++;
+    }
+}
+
+void GpuTiledSimulation::setCells(const std::vector<uint8_t>& cells)
+{
+    int current = getCurrentBuffer();
+    std::vector<uint8_t> tileCells((size_t)tileW * tileH);
+    for (int tileIndex = 0; tileIndex < (int)tiles.size(); ++tileIndex)
+    {
+        int tileX = tileIndex % tilesX;
+        int tileY = tileIndex / tilesX;
+        for (int row = 0; row < tileH; ++row)
+        {
+            std::copy_n(cells.data() + (size_t)(tileY * tileH + row) * gridW + (size_t)tileX * tileW, tileW, tileCells.data() + (size_t)row * tileW);
+        }
+
+        Tile& tile = tiles[tileIndex];
+        if (tile.slot >= 0)
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTextureSubImage2D(slots[tile.slot].textures[current]->getID(), 0, MAX_HALO, MAX_HALO, tileW, tileH, GL_RED_INTEGER, GL_UNSIGNED_BYTE, tileCells.data());
+        }
+        else
+        {
+            if (!tile.hostCells[current])
+            {
+                tile.hostCells[current] = static_cast<uint8_t*>(hostPool->allocate());
+            }
+            std::copy(tileCells.begin(), tileCells.end(), tile.hostCells[current]);
+        }
+    }
+}
+
+std::vector<uint8_t> GpuTiledSimulation::getCells() const
+{
+    int current = getCurrentBuffer();
+    std::vector<uint8_t> cells((size_t)gridW * gridH);
+    std::vector<uint8_t> tileCells((size_t)tileW * tileH);
+
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    for (int tileIndex = 0; tileIndex < (int)tiles.size(); ++tileIndex)
+    {
+        const Tile& tile = tiles[tileIndex];
+        const uint8_t* source = tile.hostCells[current];
+        if (tile.slot < 0 && !source)
+        {
+            continue;
+        }
+        if (tile.slot >= 0)
+        {
+            glGetTextureSubImage(slots[tile.slot].textures[current]->getID(), 0, MAX_HALO, MAX_HALO, 0, tileW, tileH, 1,
+                GL_RED_INTEGER, GL_UNSIGNED_BYTE, (GLsizei)tileCells.size(), tileCells.data());
+            source = tileCells.data();
+        }
+
+        int tileX = tileIndex % tilesX;
+        int tileY = tileIndex / tilesX;
+        for (int row = 0; row < tileH; ++row)
+        {
+            std::copy_n(source + (size_t)row * tileW, tileW, cells.data() + (size_t)(tileY * tileH + row) * gridW + (size_t)tileX * tileW);
+        }
+    }
+    return cells;
+}
+
+int GpuTiledSimulation::getTileWidth() const
+{
+    return tileW;
+}
+
+int GpuTiledSimulation::getTileHeight() const
+{
+    return tileH;
+}
+
+int GpuTiledSimulation::getTilesCount() const
+{
+    return (int)tiles.size();
+}
+
+size_t GpuTiledSimulation::getTileBytes() const
+{
+    return 2 * (size_t)(tileW + 2 * MAX_HALO) * (tileH + 2 * MAX_HALO);
+}
+
+uint64_t GpuTiledSimulation::getGeneration() const
+{
+    return generation;
+}
+
+uint64_t GpuTiledSimulation::getPagedInTiles() const
+{
+    return pagedInTiles;
+}
+
+int GpuTiledSimulation::getCurrentBuffer() const
+{
+    return (int)(generation % 2);
+}
+
+bool GpuTiledSimulation::makeResident(int tileIndex)
+{
+    Tile& tile = tiles[tileIndex];
+    if (tile.slot >= 0)
+    {
+        return true;
+    }
+
+    int slotIndex = allocateSlot(tileIndex);
+    if (slotIndex < 0)
+    {
+        std::cerr << "No VRAM left for a single tile of " << tileW << "x" << tileH << " cells" << std::endl;
+        return false;
+    }
+    slots[slotIndex].tile = tileIndex;
+    tile.slot = slotIndex;
+
+    // Tiles are only paged in to be stepped, the other generation is written before anything reads it
+    // A tile without host cells was never set and is dead
+    int current = getCurrentBuffer();
+    GLuint texture = slots[slotIndex].textures[current]->getID();
+    if (!tile.hostCells[current])
+    {
+        glClearTexImage(texture, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+    }
+    else
+    {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTextureSubImage2D(texture, 0, MAX_HALO, MAX_HALO, tileW, tileH, GL_RED_INTEGER, GL_UNSIGNED_BYTE, tile.hostCells[current]);
+    }
+    for (uint8_t*& hostCells : tile.hostCells)
+    {
+        if (hostCells)
+        {
+            hostPool->deallocate(hostCells);
+            hostCells = nullptr;
+        }
+    }
+    pagedInTiles++;
+    return true;
+}
+
+int GpuTiledSimulation::allocateSlot(int tileIndex)
+{
+    // New textures until the budget or VRAM runs out
+    if (slots.size() < maxResidentTiles && !isSlotAllocationFailed)
+    {
+        while (glGetError() != GL_NO_ERROR) {}
+        Slot slot;
+        for (auto& texture : slot.textures)
+        {
+            texture = std::make_unique<Texture2D>(tileW + 2 * MAX_HALO, tileH + 2 * MAX_HALO);
+        }
+        if (glGetError() == GL_NO_ERROR)
+        {
+            slots.push_back(std::move(slot));
+            return (int)slots.size() - 1;
+        }
+        isSlotAllocationFailed = true;
+    }
+    if (slots.empty())
+    {
+        return -1;
+    }
+
+    // The resident tile whose next step is the furthest away
+    int tilesCount = (int)tiles.size();
+    int victimSlot = 0;
+    int victimDistance = -1;
+    for (int i = 0; i < (int)slots.size(); ++i)
+    {
+        int distance = (slots[i].tile - tileIndex + tilesCount) % tilesCount;
+        if (distance > victimDistance)
+        {
+            victimSlot = i;
+            victimDistance = distance;
+        }
+    }
+    pageOut(slots[victimSlot].tile);
+    return victimSlot;
+}
+
+void GpuTiledSimulation::pageOut(int tileIndex)
+{
+    Tile& tile = tiles[tileIndex];
+    Slot& slot = slots[tile.slot];
+
+    // A stepped tile is still read by the halos of its unstepped neighbors, so both generations are kept
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    int current = getCurrentBuffer();
+    for (int buffer : { current, 1 - current })
+    {
+        if (buffer != current && !tile.isStepped)
+        {
+            continue;
+        }
+
+        uint8_t*& hostCells = tile.hostCells[buffer];
+        if (!hostCells)
+        {
+            hostCells = static_cast<uint8_t*>(hostPool->allocate());
+        }
+        glGetTextureSubImage(slot.textures[buffer]->getID(), 0, MAX_HALO, MAX_HALO, 0, tileW, tileH, 1,
+            GL_RED_INTEGER, GL_UNSIGNED_BYTE, (GLsizei)((size_t)tileW * tileH), hostCells);
+    }
+
+    slot.tile = -1;
+    tile.slot = -1;
+}
+
+void GpuTiledSimulation::fillHalo(int tileIndex)
+{
+    const int range = neighborSearchRange;
+    const int current = getCurrentBuffer();
+    const int tileX = tileIndex % tilesX;
+    const int tileY = tileIndex / tilesX;
+    GLuint target = slots[tiles[tileIndex].slot].textures[current]->getID();
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, tileW);
+    for (const HaloRegion& region : Halo::getRegions(tileW, tileH, range, MAX_HALO))
+    {
+        // The tile itself is already in the texture
+        if (region.neighborX == 0 && region.neighborY == 0)
+        {
+            continue;
+        }
+
+        const Tile& neighbor = tiles[Halo::wrap(tileY + region.neighborY, tilesY) * tilesX + Halo::wrap(tileX + region.neighborX, tilesX)];
+        if (neighbor.slot >= 0)
+        {
+            glCopyImageSubData(
+                slots[neighbor.slot].textures[current]->getID(), GL_TEXTURE_2D, 0, MAX_HALO + region.sourceColumn, MAX_HALO + region.sourceRow, 0,
+                target, GL_TEXTURE_2D, 0, region.targetColumn, region.targetRow, 0,
+                region.columnsCount, region.rowsCount, 1
+            );
+        }
+        else if (!neighbor.hostCells[current])
+        {
+            glClearTexSubImage(target, 0, region.targetColumn, region.targetRow, 0, region.columnsCount, region.rowsCount, 1, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+        }
+        else
+        {
+            const uint8_t* source = neighbor.hostCells[current] + (size_t)region.sourceRow * tileW + region.sourceColumn;
+            glTextureSubImage2D(target, 0, region.targetColumn, region.targetRow, region.columnsCount, region.rowsCount, GL_RED_INTEGER, GL_UNSIGNED_BYTE, source);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "FixedBlockPool.h"
+#include "RulesBuffers.h"
+#include "Shader.h"
+#include "SimulationRules.h"
+#include "Texture2D.h"
+
+// GpuTiledSimulation class for stepping a world larger than GL_MAX_TEXTURE_SIZE or than VRAM on the GPU.
+// The world is split into tiles, each one has a texture per generation with a MAX_HALO cell border.
+// Before a tile is stepped its border is filled from the current generation of its neighbors, with
+// glCopyImageSubData from resident neighbors or an upload from the host copy of paged-out ones.
+// At most maxResidentTiles tiles have textures; when a tile needs one, the resident tile that will be
+// stepped last is paged out to host memory. Tiles are stepped in a fixed order, so that is Belady's choice,
+// while LRU would page every tile in and out once per generation.
+class GpuTiledSimulation
+{
+public:
+    static const int DEFAULT_MAX_TILE_SIZE = 4096;
+    static const int MAX_HALO = 10; // Largest neighbor search range
+
+    // False when a side has no divisor that gives tiles close to maxTileSize, e.g. a prime width
+    static bool canSplit(int gridW, int gridH, int maxTileSize = DEFAULT_MAX_TILE_SIZE);
+
+    GpuTiledSimulation(int gridW, int gridH, int maxTileSize = DEFAULT_MAX_TILE_SIZE); // Only sizes canSplit() accepts
+    GpuTiledSimulation(const GpuTiledSimulation&) = delete;
+    GpuTiledSimulation& operator=(const GpuTiledSimulation&) = delete;
+
+    bool setRules(const SimulationRules& rules); // False when the neighbor search range is wider than a tile
+    void step(int generations);
+    void setCells(const std::vector<uint8_t>& cells);
+    std::vector<uint8_t> getCells() const; // Synchronous, meant for tools
+
+    int getTileWidth() const;
+    int getTileHeight() const;
+    int getTilesCount() const;
+    size_t getTileBytes() const; // VRAM of one resident tile
+    uint64_t getGeneration() const;
+    uint64_t getPagedInTiles() const;
+
+    size_t maxResidentTiles = 64;
+private:
+    struct Tile
+    {
+        uint8_t* hostCells[2] = { nullptr, nullptr }; // Per generation parity, only the cells inside the halo
+        int slot = -1;
+        bool isStepped = false; // In the generation being stepped
+    };
+
+    struct Slot
+    {
+        std::unique_ptr<Texture2D> textures[2];
+        int tile = -1;
+    };
+
+    int gridW = 0;
+    int gridH = 0;
+    int tileW = 0;
+    int tileH = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    int neighborSearchRange = 1;
+    GLuint groupsX, groupsY;
+
+    std::unique_ptr<Shader> computeShader;
+    RulesBuffers rulesBuffers;
+
+    std::vector<Tile> tiles;
+    std::vector<Slot> slots;
+    std::unique_ptr<FixedBlockPool> hostPool; // Host copies, paged tiles churn blocks of one size
+    uint64_t generation = 0;
+    uint64_t pagedInTiles = 0;
+    bool isSlotAllocationFailed = false;
+
+    int getCurrentBuffer() const;
+    bool makeResident(int tileIndex);
+    int allocateSlot(int tileIndex);
+    void pageOut(int tileIndex);
+    void fillHalo(int tileIndex);
+};
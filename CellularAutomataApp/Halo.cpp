@@ -0,0 +1,29 @@
+#include "Halo.h"
+
+std::array<HaloRegion, Halo::REGIONS_COUNT> Halo::getRegions(int tileW, int tileH, int range, int border)
+{
+    std::array<HaloRegion, REGIONS_COUNT> regions;
+    int index = 0;
+    for (int ny = -1; ny <= 1; ++ny)
+    {
+        for (int nx = -1; nx <= 1; ++nx)
+        {
+            // Cells of the neighbor that fall into the halo, and where they go
+            HaloRegion& region = regions[index++];
+            region.neighborX = nx;
+            region.neighborY = ny;
+            region.sourceColumn = nx < 0 ? tileW - range : 0;
+            region.sourceRow = ny < 0 ? tileH - range : 0;
+            region.targetColumn = nx < 0 ? border - range : (nx == 0 ? border : border + tileW);
+            region.targetRow = ny < 0 ? border - range : (ny == 0 ? border : border + tileH);
+            region.columnsCount = nx == 0 ? tileW : range;
+            region.rowsCount = ny == 0 ? tileH : range;
+        }
+    }
+    return regions;
+}
+
+int Halo::wrap(int index, int count)
+{
+    return (index % count + count) % count;
+}
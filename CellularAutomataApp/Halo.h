@@ -0,0 +1,32 @@
+#pragma once
+#include <array>
+
+// Block of one neighbor of a tile that lands in the haloed copy of the tile
+struct HaloRegion
+{
+    int neighborX = 0; // -1, 0 or 1, the tile itself is 0, 0
+    int neighborY = 0;
+    int sourceColumn = 0; // In the neighbor
+    int sourceRow = 0;
+    int targetColumn = 0; // In the haloed copy
+    int targetRow = 0;
+    int columnsCount = 0;
+    int rowsCount = 0;
+};
+
+// Halo class for the wrap-around halo arithmetic shared by the tiled and chunked worlds.
+// A haloed copy holds the tile at (border, border) with border >= range cells around it; only the
+// range cells next to the tile are filled from the neighbors.
+class Halo
+{
+public:
+    Halo() = delete;
+
+    static const int REGIONS_COUNT = 9;
+
+    // The tile itself and its 8 neighbors, row by row from the top left one
+    static std::array<HaloRegion, REGIONS_COUNT> getRegions(int tileW, int tileH, int range, int border);
+
+    // Index of a neighbor on a toroidal grid of count tiles
+    static int wrap(int index, int count);
+};
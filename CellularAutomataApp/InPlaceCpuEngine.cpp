@@ -0,0 +1,116 @@
+#include "InPlaceCpuEngine.h"
+#include <algorithm>
+#include <cstring>
+#include "ThreadPool.h"
+
+EngineType InPlaceCpuEngine::getType() const
+{
+    return EngineType::InPlaceCpu;
+}
+
+void InPlaceCpuEngine::setRules(const SimulationRules& rules)
+{
+    kernel = SparseKernel::compile(rules);
+    ranges.set(rules);
+}
+
+void InPlaceCpuEngine::step(CpuWorld& world)
+{
+    const int w = world.width;
+    const int h = world.height;
+    const int range = kernel.neighborSearchRange;
+    const int diameter = range * 2 + 1;
+    uint8_t* cells = world.cells.data();
+
+    // Nothing else keeps a second world around
+    world.releaseScratch();
+
+    int bandsCount = std::max(std::min(ThreadPool::getThreadCount(), h / diameter), 1);
+    bands.resize(bandsCount);
+    for (int i = 0; i < bandsCount; ++i)
+    {
+        Band& band = bands[i];
+        band.firstRow = (int)((int64_t)h * i / bandsCount);
+        band.endRow = (int)((int64_t)h * (i + 1) / bandsCount);
+        band.rowsAbove.resize((size_t)range * w);
+        band.rowsBelow.resize((size_t)range * w);
+        band.rollingRows.resize((size_t)(range + 1) * w);
+        band.nextRow.resize(w);
+    }
+
+    auto getWrappedRow = [&](int y) { return cells + (size_t)((y % h + h) % h) * w; };
+
+    // Halos have to be copied before any band starts writing
+    ThreadPool::parallelFor(0, bandsCount, [&](int bandBegin, int bandEnd)
+        {
+            for (int i = bandBegin; i < bandEnd; ++i)
+            {
+                Band& band = bands[i];
+                for (int k = 0; k < range; ++k)
+                {
+                    memcpy(band.rowsAbove.data() + (size_t)k * w, getWrappedRow(band.firstRow - range + k), w);
+                    memcpy(band.rowsBelow.data() + (size_t)k * w, getWrappedRow(band.endRow + k), w);
+                }
+            }
+        });
+
+    std::vector<int> columns(w + 2 * range);
+    for (int i = 0; i < (int)columns.size(); ++i)
+    {
+        columns[i] = ((i - range) % w + w) % w;
+    }
+
+    ThreadPool::parallelFor(0, bandsCount, [&](int bandBegin, int bandEnd)
+        {
+            std::vector<const uint8_t*> rows(diameter);
+            for (int i = bandBegin; i < bandEnd; ++i)
+            {
+                Band& band = bands[i];
+                for (int y = band.firstRow; y < band.endRow; ++y)
+                {
+                    // Previous generation of every window row, rows of this band above y are already overwritten
+                    for (int dy = -range; dy <= range; ++dy)
+                    {
+                        int row = y + dy;
+                        if (row < band.firstRow)
+                        {
+                            rows[dy + range] = band.rowsAbove.data() + (size_t)(row - band.firstRow + range) * w;
+                        }
+                        else if (row >= band.endRow)
+                        {
+                            rows[dy + range] = band.rowsBelow.data() + (size_t)(row - band.endRow) * w;
+                        }
+                        else if (row < y)
+                        {
+                            rows[dy + range] = band.rollingRows.data() + (size_t)(row % (range + 1)) * w;
+                        }
+                        else
+                        {
+                            rows[dy + range] = cells + (size_t)row * w;
+                        }
+                    }
+
+                    const uint8_t* currentRow = cells + (size_t)y * w;
+                    for (int x = 0; x < w; ++x)
+                    {
+                        float sum = 0.0f;
+                        for (const KernelTapGroup& group : kernel.groups)
+                        {
+                            int count = 0;
+                            for (int t = group.firstTap; t < group.firstTap + group.tapCount; ++t)
+                            {
+                                const KernelTap& tap = kernel.taps[t];
+                                count += rows[tap.dy + range][columns[x + tap.dx + range]];
+                            }
+                            sum += float(count) * group.weight;
+                        }
+                        band.nextRow[x] = ranges.apply(currentRow[x], sum);
+                    }
+
+                    // Keep the previous generation of y for the rows below it, then overwrite it
+                    memcpy(band.rollingRows.data() + (size_t)(y % (range + 1)) * w, currentRow, w);
+                    memcpy(cells + (size_t)y * w, band.nextRow.data(), w);
+                }
+            }
+        });
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "CpuEngine.h"
+#include "SparseKernel.h"
+
+// InPlaceCpuEngine class for worlds close to the memory limit, the next generation overwrites the current one.
+// Rows are split into bands. Before any band is written, every band copies the r rows above and below it,
+// then it keeps the previous generation of its last r rows in a rolling buffer while it sweeps down.
+// Memory is one world plus O(r * width) per band, summation is the same as in ScalarCpuEngine.
+class InPlaceCpuEngine : public CpuEngine
+{
+public:
+    EngineType getType() const override;
+    void setRules(const SimulationRules& rules) override;
+    void step(CpuWorld& world) override;
+private:
+    struct Band
+    {
+        int firstRow = 0;
+        int endRow = 0;
+        std::vector<uint8_t> rowsAbove;   // Previous generation of rows [firstRow - r, firstRow)
+        std::vector<uint8_t> rowsBelow;   // Previous generation of rows [endRow, endRow + r)
+        std::vector<uint8_t> rollingRows; // Previous generation of the last r + 1 rows written
+        std::vector<uint8_t> nextRow;
+    };
+
+    SparseKernel kernel;
+    TransitionRanges ranges;
+    std::vector<Band> bands;
+};
@@ -0,0 +1,92 @@
+#include "KernelFeatures.h"
+#include <algorithm>
+#include <math.h>
+#include "RadialKernel.h"
+
+static int computeRank(std::vector<double> matrix, int size)
+{
+    const double epsilon = 1e-6;
+
+    int rank = 0;
+    for (int column = 0; column < size && rank < size; ++column)
+    {
+        // Partial pivoting
+        int pivot = rank;
+        for (int row = rank + 1; row < size; ++row)
+        {
+            if (fabs(matrix[row * size + column]) > fabs(matrix[pivot * size + column]))
+            {
+                pivot = row;
+            }
+        }
+        if (fabs(matrix[pivot * size + column]) < epsilon)
+        {
+            continue;
+        }
+
+        for (int c = 0; c < size; ++c)
+        {
+            std::swap(matrix[pivot * size + c], matrix[rank * size + c]);
+        }
+        for (int row = rank + 1; row < size; ++row)
+        {
+            double factor = matrix[row * size + column] / matrix[rank * size + column];
+            for (int c = column; c < size; ++c)
+            {
+                matrix[row * size + c] -= factor * matrix[rank * size + c];
+            }
+        }
+        rank++;
+    }
+    return rank;
+}
+
+KernelFeatures KernelFeatures::compute(const SimulationRules& rules)
+{
+    KernelFeatures features;
+    features.neighborSearchRange = rules.neighborSearchRange;
+
+    int diameter = rules.neighborSearchRange * 2 + 1;
+    features.denseTaps = diameter * diameter;
+
+    std::vector<float> weights;
+    std::vector<double> matrix(features.denseTaps, 0.0);
+    features.nonZeroTaps = 0;
+    for (int i = 0; i < features.denseTaps && i < (int)rules.kernel.size(); ++i)
+    {
+        float value = rules.kernel[i];
+        bool isRunContinued = i % diameter != 0 && rules.kernel[i - 1] == value;
+        if (value != 0.0f && !isRunContinued)
+        {
+            features.rowRuns++;
+        }
+
+        matrix[i] = value;
+        if (value != floorf(value))
+        {
+            features.isInteger = false;
+        }
+        if (value != 0.0f)
+        {
+            features.nonZeroTaps++;
+            weights.push_back(value);
+        }
+    }
+
+    std::sort(weights.begin(), weights.end());
+    features.distinctWeights = (int)(std::unique(weights.begin(), weights.end()) - weights.begin());
+    features.isUniform = features.distinctWeights <= 1;
+    features.rank = computeRank(matrix, diameter);
+
+    features.isRadial = rules.isRadiallySymmetric();
+    if (features.isRadial)
+    {
+        features.radialRuns = RadialKernel::compile(rules).getSlideWork();
+    }
+    return features;
+}
+
+float KernelFeatures::getSparsity() const
+{
+    return 1.0f - (float)nonZeroTaps / (float)denseTaps;
+}
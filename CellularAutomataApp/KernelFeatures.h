@@ -0,0 +1,21 @@
+#pragma once
+#include "SimulationRules.h"
+
+// Properties of a kernel that decide which engine can evaluate it cheaply
+struct KernelFeatures
+{
+    int neighborSearchRange = 1;
+    int denseTaps = 9;      // (2r+1)^2 texels read by the dense loop
+    int nonZeroTaps = 9;
+    int distinctWeights = 1; // Among the non-zero weights
+    int rank = 1;           // Numerical rank of the kernel matrix, 1 means separable
+    bool isUniform = true;  // All non-zero weights are equal
+    bool isInteger = true;  // All weights are whole numbers
+    bool isRadial = false;  // Weights depend only on the distance from the center
+    int radialRuns = 0;     // Disc edge runs slid per cell by the radial engine
+    int rowRuns = 0;        // Runs of equal non-zero weight along the kernel rows
+
+    static KernelFeatures compute(const SimulationRules& rules);
+
+    float getSparsity() const; // Fraction of zero weights
+};
@@ -0,0 +1,195 @@
+#include "OutOfCoreSimulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include "Halo.h"
+#include "TraceRecorder.h"
+
+OutOfCoreSimulation::OutOfCoreSimulation(TileStore& store)
+    : store(store)
+{
+}
+
+bool OutOfCoreSimulation::setRules(const SimulationRules& rules, EngineType engineType)
+{
+    engine = CpuEngine::create(engineType);
+    if (!engine || !engine->supports(rules) || rules.neighborSearchRange > store.getTileSize())
+    {
+        engine.reset();
+        return false;
+    }
+
+    engine->setRules(rules);
+    neighborSearchRange = rules.neighborSearchRange;
+    int tileSize = store.getTileSize();
+    tileWorld.resize(tileSize + 2 * neighborSearchRange, tileSize + 2 * neighborSearchRange);
+    return true;
+}
+
+bool OutOfCoreSimulation::randomize(float density, unsigned int seed)
+{
+    int buffer = (int)(store.getGeneration() % TileStore::BUFFERS_COUNT);
+    size_t tileBytes = (size_t)store.getTileSize() * store.getTileSize();
+    uint32_t threshold = static_cast<uint32_t>(density * 4294967295.0);
+
+    for (int tileY = 0; tileY < store.getTilesY(); ++tileY)
+    {
+        for (int tileX = 0; tileX < store.getTilesX(); ++tileX)
+        {
+            uint8_t* tile = store.getTile(buffer, tileX, tileY);
+            if (!tile)
+            {
+                return false;
+            }
+
+            // Seeded per tile, so a world is the same whatever order the tiles are filled in
+            std::mt19937 generator(seed ^ (uint32_t)(tileY * store.getTilesX() + tileX) * 2654435761u);
+            for (size_t i = 0; i < tileBytes; ++i)
+            {
+                tile[i] = generator() < threshold ? 1 : 0;
+            }
+        }
+    }
+    store.flush();
+    return true;
+}
+
+bool OutOfCoreSimulation::loadTileWithHalo(int buffer, int tileX, int tileY)
+{
+    const int tileSize = store.getTileSize();
+    const int range = neighborSearchRange;
+    const int tilesX = store.getTilesX();
+    const int tilesY = store.getTilesY();
+    const int worldW = tileWorld.width;
+
+    for (const HaloRegion& region : Halo::getRegions(tileSize, tileSize, range, range))
+    {
+        const uint8_t* tile = store.getTile(buffer, Halo::wrap(tileX + region.neighborX, tilesX), Halo::wrap(tileY + region.neighborY, tilesY));
+        if (!tile)
+        {
+            return false;
+        }
+        for (int row = 0; row < region.rowsCount; ++row)
+        {
+            memcpy(tileWorld.cells.data() + (size_t)(region.targetRow + row) * worldW + region.targetColumn,
+                tile + (size_t)(region.sourceRow + row) * tileSize + region.sourceColumn,
+                region.columnsCount);
+        }
+    }
+    return true;
+}
+
+bool OutOfCoreSimulation::step()
+{
+    if (!engine)
+    {
+        return false;
+    }
+
+    ScopedTraceEvent trace("Out-of-core step", "simulation");
+    const int tileSize = store.getTileSize();
+    const int range = neighborSearchRange;
+    const int tilesX = store.getTilesX();
+    const int tilesY = store.getTilesY();
+    int source = (int)(store.getGeneration() % TileStore::BUFFERS_COUNT);
+    int target = 1 - source;
+
+    // The band below the current one is already mapped as a halo, so the one after it is prefetched.
+    // Prefetching only helps if the cache holds the three source bands, the prefetched one and the target band.
+    bool isPrefetching = store.maxCachedTiles >= (size_t)tilesX * 5;
+    if (isPrefetching)
+    {
+        for (int tileX = 0; tileX < tilesX; ++tileX)
+        {
+            store.prefetchTile(source, tileX, (tilesY - 1) % tilesY);
+            store.prefetchTile(source, tileX, 0);
+            store.prefetchTile(source, tileX, 1 % tilesY);
+        }
+    }
+
+    for (int tileY = 0; tileY < tilesY; ++tileY)
+    {
+        for (int tileX = 0; isPrefetching && tileX < tilesX; ++tileX)
+        {
+            store.prefetchTile(source, tileX, (tileY + 2) % tilesY);
+        }
+
+        for (int tileX = 0; tileX < tilesX; ++tileX)
+        {
+            if (!loadTileWithHalo(source, tileX, tileY))
+            {
+                return false;
+            }
+
+            engine->invalidate();
+            engine->step(tileWorld);
+
+            uint8_t* tile = store.getTile(target, tileX, tileY);
+            if (!tile)
+            {
+                return false;
+            }
+            for (int row = 0; row < tileSize; ++row)
+            {
+                memcpy(tile + (size_t)row * tileSize, tileWorld.cells.data() + (size_t)(row + range) * tileWorld.width + range, tileSize);
+            }
+        }
+    }
+
+    store.setGeneration(store.getGeneration() + 1);
+    return true;
+}
+
+uint64_t OutOfCoreSimulation::getGeneration() const
+{
+    return store.getGeneration();
+}
+
+bool OutOfCoreSimulation::run(const OutOfCoreConfig& config, const EngineCostModel& costModel)
+{
+    TileStore store;
+    bool isExisting = std::filesystem::exists(config.storePath);
+    if (isExisting ? !store.open(config.storePath) : !store.create(config.storePath, config.worldSize, config.worldSize, config.tileSize))
+    {
+        return false;
+    }
+    store.maxCachedTiles = std::max<size_t>(config.cacheBytes / ((size_t)store.getTileSize() * store.getTileSize()), 16);
+
+    OutOfCoreSimulation simulation(store);
+    SimulationRules rules;
+
+    EngineType bestEngine = costModel.selectCpuEngine(rules, store.getTileSize() * store.getTileSize());
+    if (bestEngine == EngineType::COUNT_ || !simulation.setRules(rules, bestEngine))
+    {
+        std::cerr << "No CPU engine supports the out-of-core rules" << std::endl;
+        return false;
+    }
+
+    if (!isExisting && !simulation.randomize(config.density, config.seed))
+    {
+        return false;
+    }
+
+    std::cout << "Out-of-core world " << store.getWidth() << "x" << store.getHeight() << " in " << store.getTileSize() << " tiles, "
+        << store.maxCachedTiles << " cached, engine: " << ENGINE_TYPE_NAMES[static_cast<int>(bestEngine)] << std::endl;
+
+    double cellsCount = (double)store.getWidth() * store.getHeight();
+    for (int i = 0; i < config.generations; ++i)
+    {
+        uint64_t misses = store.getCacheMisses();
+        auto start = std::chrono::steady_clock::now();
+        if (!simulation.step())
+        {
+            std::cerr << "Failed to map a tile" << std::endl;
+            return false;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "Generation " << simulation.getGeneration() << ": " << cellsCount / seconds / 1.0e6 << " Mcells/s, "
+            << store.getCacheMisses() - misses << " tiles mapped" << std::endl;
+    }
+    store.flush();
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <memory>
+#include "CpuEngine.h"
+#include "EngineCostModel.h"
+#include "TileStore.h"
+
+struct OutOfCoreConfig
+{
+    std::filesystem::path storePath;
+    int64_t worldSize = 1 << 16; // Opened as is when the store already exists
+    int tileSize = 1024;
+    int generations = 10;
+    size_t cacheBytes = (size_t)1 << 30;
+    float density = 0.3f;
+    unsigned int seed = 12345;
+};
+
+// OutOfCoreSimulation class for stepping a TileStore world that does not fit in RAM.
+// Tiles are stepped one band of tile rows at a time: every tile is copied with an r cell halo from its
+// neighbors into a small CpuWorld, stepped by a CPU engine and its center written to the other generation.
+// The wrapped halo of that small world is wrong after the step, but the center only depends on real cells.
+// The band two rows ahead is prefetched while the current one is stepped.
+class OutOfCoreSimulation
+{
+public:
+    explicit OutOfCoreSimulation(TileStore& store);
+
+    // Opens or creates the store, steps it with the CPU engine the cost model predicts to be fastest and reports throughput
+    static bool run(const OutOfCoreConfig& config, const EngineCostModel& costModel);
+
+    bool setRules(const SimulationRules& rules, EngineType engineType); // False when the engine does not support the rules
+    bool randomize(float density, unsigned int seed);
+    bool step();
+    uint64_t getGeneration() const;
+private:
+    TileStore& store;
+    std::unique_ptr<CpuEngine> engine;
+    int neighborSearchRange = 1;
+    CpuWorld tileWorld;
+
+    bool loadTileWithHalo(int buffer, int tileX, int tileY);
+};
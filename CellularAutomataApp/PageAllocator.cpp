@@ -0,0 +1,81 @@
+#include "PageAllocator.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cstdlib>
+#include <sys/mman.h>
+#endif
+
+size_t PageAllocator::roundUp(size_t bytes)
+{
+    return (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+}
+
+#ifdef _WIN32
+
+// Large pages need the lock memory privilege, which is only enabled once
+static bool enableLargePages()
+{
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+    {
+        return false;
+    }
+
+    TOKEN_PRIVILEGES privileges = {};
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    bool isEnabled = LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid)
+        && AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr)
+        && GetLastError() == ERROR_SUCCESS;
+    CloseHandle(token);
+    return isEnabled && GetLargePageMinimum() > 0 && HUGE_PAGE_BYTES % GetLargePageMinimum() == 0;
+}
+
+void* PageAllocator::allocate(size_t bytes, bool& isHugePages)
+{
+    static const bool isLargePagesEnabled = enableLargePages();
+
+    isHugePages = false;
+    if (isLargePagesEnabled)
+    {
+        void* data = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (data)
+        {
+            isHugePages = true;
+            return data;
+        }
+    }
+    return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void PageAllocator::deallocate(void* data)
+{
+    VirtualFree(data, 0, MEM_RELEASE);
+}
+
+#else
+
+void* PageAllocator::allocate(size_t bytes, bool& isHugePages)
+{
+    void* data = nullptr;
+    isHugePages = false;
+    if (posix_memalign(&data, HUGE_PAGE_BYTES, bytes) != 0)
+    {
+        return nullptr;
+    }
+
+#ifdef MADV_HUGEPAGE
+    isHugePages = madvise(data, bytes, MADV_HUGEPAGE) == 0;
+#endif
+    return data;
+}
+
+void PageAllocator::deallocate(void* data)
+{
+    free(data);
+}
+
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+
+// PageAllocator class for large allocations straight from the OS, backed by huge pages where available.
+// Windows uses large pages when the process may lock memory (SeLockMemoryPrivilege) and falls back to
+// normal pages; other platforms align to 2 MB and ask for transparent huge pages with madvise.
+class PageAllocator
+{
+public:
+    PageAllocator() = delete;
+
+    static const size_t HUGE_PAGE_BYTES = (size_t)2 << 20;
+
+    static size_t roundUp(size_t bytes); // To a multiple of HUGE_PAGE_BYTES
+    static void* allocate(size_t bytes, bool& isHugePages); // bytes has to be rounded up, nullptr on failure
+    static void deallocate(void* data);
+};
@@ -0,0 +1,331 @@
+#include "ProfilerUI.h"
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <vector>
+#include "imgui/imgui.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "TraceRecorder.h"
+#include "WindowsFileDialog.h"
+
+const int TIMELINE_FRAMES = 120;
+const float TIMELINE_HEIGHT = 120.0f;
+const float FLAME_ROW_HEIGHT = 20.0f;
+const int CPU_ZONES_COUNT = static_cast<int>(CpuZone::COUNT_);
+
+static std::vector<CpuZoneEvent> timelineEvents;
+static uint64_t timelineFirstFrame = 0;
+static uint64_t selectedFrame = 0;
+static bool isTimelinePaused = false;
+
+static ImU32 getZoneColor(CpuZone zone)
+{
+    float hue = static_cast<float>(zone) / static_cast<float>(CPU_ZONES_COUNT);
+    return ImColor::HSV(hue, 0.55f, 0.85f);
+}
+
+static double toMilliseconds(int64_t ns)
+{
+    return ns / 1.0e6;
+}
+
+static const CpuZoneEvent* frameEvents[TIMELINE_FRAMES] = {};
+
+// Zones of other threads are not part of the frame phases, the flame view shows them in their own lanes
+static bool isFrameThreadEvent(const CpuZoneEvent& event)
+{
+    return event.thread == CpuProfiler::getFrameThreadIndex();
+}
+
+static void indexFrameEvents()
+{
+    std::fill(std::begin(frameEvents), std::end(frameEvents), nullptr);
+    for (const CpuZoneEvent& event : timelineEvents)
+    {
+        if (event.zone == CpuZone::Frame && isFrameThreadEvent(event) && event.frame >= timelineFirstFrame && event.frame < timelineFirstFrame + TIMELINE_FRAMES)
+        {
+            frameEvents[event.frame - timelineFirstFrame] = &event;
+        }
+    }
+}
+
+static const CpuZoneEvent* findFrameEvent(uint64_t frame)
+{
+    if (frame < timelineFirstFrame || frame >= timelineFirstFrame + TIMELINE_FRAMES)
+    {
+        return nullptr;
+    }
+    return frameEvents[frame - timelineFirstFrame];
+}
+
+static void drawFrameTooltip(uint64_t frame)
+{
+    const CpuZoneEvent* frameEvent = findFrameEvent(frame);
+    if (!frameEvent)
+    {
+        return;
+    }
+
+    ImGui::BeginTooltip();
+    ImGui::Text("Frame %llu: %.3f ms", (unsigned long long)frame, toMilliseconds(frameEvent->endNs - frameEvent->startNs));
+    for (auto it = timelineEvents.rbegin(); it != timelineEvents.rend(); ++it)
+    {
+        if (it->frame == frame && it->depth == 1 && isFrameThreadEvent(*it))
+        {
+            ImGui::ColorButton("##zone", ImColor(getZoneColor(it->zone)), ImGuiColorEditFlags_NoTooltip, ImVec2(10, 10));
+            ImGui::SameLine();
+            ImGui::Text("%s: %.3f ms", CPU_ZONE_NAMES[static_cast<int>(it->zone)], toMilliseconds(it->endNs - it->startNs));
+        }
+    }
+    ImGui::EndTooltip();
+}
+
+void ProfilerUI::drawGpuStatistics()
+{
+    ImGui::Text("GPU time (ms):");
+
+    if (ImGui::BeginTable("GpuZones", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("Mean");
+        ImGui::TableSetupColumn("P50");
+        ImGui::TableSetupColumn("P99");
+        ImGui::TableSetupColumn("Samples");
+        ImGui::TableSetupColumn("Late frames");
+        ImGui::TableHeadersRow();
+
+        for (int i = 0; i < static_cast<int>(GpuZone::COUNT_); ++i)
+        {
+            GpuZone zone = static_cast<GpuZone>(i);
+            RollingStatistics::Summary summary = GpuProfiler::getStatistics(zone);
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::Text("%s", GPU_ZONE_NAMES[i]);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", summary.mean);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", summary.p50);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", summary.p99);
+            ImGui::TableNextColumn(); ImGui::Text("%d", summary.count);
+            ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)GpuProfiler::getLateFrames(zone));
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Text("Simulation step samples are per generation, the others per frame.");
+
+    if (ImGui::Button("Reset GPU statistics"))
+    {
+        GpuProfiler::reset();
+    }
+}
+
+void ProfilerUI::drawCpuTimeline()
+{
+    ImGui::Text("CPU frame phases:");
+    ImGui::Checkbox("Pause timeline", &isTimelinePaused);
+
+    // Take a snapshot of the last complete frames
+    uint64_t currentFrame = CpuProfiler::getFrameIndex();
+    if (!isTimelinePaused && currentFrame > 1)
+    {
+        uint64_t lastCompleteFrame = currentFrame - 1;
+        timelineFirstFrame = lastCompleteFrame >= TIMELINE_FRAMES ? lastCompleteFrame - TIMELINE_FRAMES + 1 : 1;
+        CpuProfiler::getEvents(timelineFirstFrame, timelineEvents);
+        timelineEvents.erase(
+            std::remove_if(timelineEvents.begin(), timelineEvents.end(), [currentFrame](const CpuZoneEvent& e) { return e.frame >= currentFrame; }),
+            timelineEvents.end()
+        );
+        if (selectedFrame < timelineFirstFrame)
+        {
+            selectedFrame = 0;
+        }
+    }
+    indexFrameEvents();
+
+    // Frame history: one stacked bar of top level phases per frame
+    double maxFrameMs = 1000.0 / 60.0;
+    for (const CpuZoneEvent& event : timelineEvents)
+    {
+        if (event.zone == CpuZone::Frame && isFrameThreadEvent(event))
+        {
+            maxFrameMs = std::max(maxFrameMs, toMilliseconds(event.endNs - event.startNs));
+        }
+    }
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    float width = ImGui::GetContentRegionAvail().x;
+    float barWidth = width / TIMELINE_FRAMES;
+    float pixelsPerMs = TIMELINE_HEIGHT / (float)maxFrameMs;
+
+    drawList->AddRectFilled(origin, ImVec2(origin.x + width, origin.y + TIMELINE_HEIGHT), IM_COL32(30, 30, 30, 255));
+
+    for (const CpuZoneEvent& event : timelineEvents)
+    {
+        if (!isFrameThreadEvent(event))
+        {
+            continue;
+        }
+
+        int column = (int)(event.frame - timelineFirstFrame);
+        float x0 = origin.x + column * barWidth;
+        float bottom = origin.y + TIMELINE_HEIGHT;
+
+        if (event.zone == CpuZone::Frame)
+        {
+            float top = bottom - (float)toMilliseconds(event.endNs - event.startNs) * pixelsPerMs;
+            drawList->AddRectFilled(ImVec2(x0, top), ImVec2(x0 + barWidth - 1.0f, bottom), IM_COL32(90, 90, 90, 255));
+        }
+        else if (event.depth == 1)
+        {
+            // Stack phases in the order they ran within the frame
+            const CpuZoneEvent* frameEvent = findFrameEvent(event.frame);
+            if (!frameEvent)
+            {
+                continue;
+            }
+            float y0 = bottom - (float)toMilliseconds(event.startNs - frameEvent->startNs) * pixelsPerMs;
+            float y1 = bottom - (float)toMilliseconds(event.endNs - frameEvent->startNs) * pixelsPerMs;
+            drawList->AddRectFilled(ImVec2(x0, y1), ImVec2(x0 + barWidth - 1.0f, y0), getZoneColor(event.zone));
+        }
+    }
+
+    float budgetY = origin.y + TIMELINE_HEIGHT - (float)(1000.0 / 60.0) * pixelsPerMs;
+    drawList->AddLine(ImVec2(origin.x, budgetY), ImVec2(origin.x + width, budgetY), IM_COL32(255, 255, 255, 120));
+
+    ImGui::InvisibleButton("##timeline", ImVec2(width, TIMELINE_HEIGHT));
+    if (ImGui::IsItemHovered() && barWidth > 0.0f)
+    {
+        uint64_t hoveredFrame = timelineFirstFrame + (uint64_t)((ImGui::GetIO().MousePos.x - origin.x) / barWidth);
+        drawFrameTooltip(hoveredFrame);
+        if (ImGui::IsItemClicked())
+        {
+            selectedFrame = hoveredFrame;
+        }
+    }
+    ImGui::Text("Max %.2f ms, line marks 16.7 ms. Click a bar to inspect the frame.", maxFrameMs);
+
+    // Flame view of the selected frame, or of the newest one
+    uint64_t frame = selectedFrame;
+    if (frame == 0)
+    {
+        for (const CpuZoneEvent& event : timelineEvents)
+        {
+            frame = std::max(frame, event.frame);
+        }
+    }
+    const CpuZoneEvent* frameEvent = findFrameEvent(frame);
+    if (!frameEvent)
+    {
+        return;
+    }
+
+    // One lane per thread: the frame thread first, then the zones of other threads that overlap the frame
+    auto isInFrame = [frame, frameEvent](const CpuZoneEvent& event)
+        {
+            if (isFrameThreadEvent(event))
+            {
+                return event.frame == frame;
+            }
+            return event.endNs > frameEvent->startNs && event.startNs < frameEvent->endNs;
+        };
+    std::vector<int> laneThreads = { CpuProfiler::getFrameThreadIndex() };
+    std::vector<int> laneDepths = { 0 };
+    for (const CpuZoneEvent& event : timelineEvents)
+    {
+        if (!isInFrame(event))
+        {
+            continue;
+        }
+        size_t lane = std::find(laneThreads.begin(), laneThreads.end(), event.thread) - laneThreads.begin();
+        if (lane == laneThreads.size())
+        {
+            laneThreads.push_back(event.thread);
+            laneDepths.push_back(0);
+        }
+        laneDepths[lane] = std::max(laneDepths[lane], event.depth);
+    }
+    std::vector<int> laneFirstRows = { 0 };
+    for (int depth : laneDepths)
+    {
+        laneFirstRows.push_back(laneFirstRows.back() + depth + 1);
+    }
+
+    ImGui::Text("Frame %llu:", (unsigned long long)frame);
+    origin = ImGui::GetCursorScreenPos();
+    int64_t frameNs = std::max<int64_t>(frameEvent->endNs - frameEvent->startNs, 1);
+    float flameHeight = laneFirstRows.back() * FLAME_ROW_HEIGHT;
+
+    drawList->AddRectFilled(origin, ImVec2(origin.x + width, origin.y + flameHeight), IM_COL32(30, 30, 30, 255));
+    for (size_t lane = 1; lane < laneThreads.size(); ++lane)
+    {
+        float laneY = origin.y + laneFirstRows[lane] * FLAME_ROW_HEIGHT - 1.0f;
+        drawList->AddLine(ImVec2(origin.x, laneY), ImVec2(origin.x + width, laneY), IM_COL32(255, 255, 255, 120));
+    }
+    for (const CpuZoneEvent& event : timelineEvents)
+    {
+        if (!isInFrame(event))
+        {
+            continue;
+        }
+
+        // Zones of other threads can start before or end after the frame
+        size_t lane = std::find(laneThreads.begin(), laneThreads.end(), event.thread) - laneThreads.begin();
+        int64_t startNs = std::clamp<int64_t>(event.startNs - frameEvent->startNs, 0, frameNs);
+        int64_t endNs = std::clamp<int64_t>(event.endNs - frameEvent->startNs, 0, frameNs);
+        float x0 = origin.x + (float)((double)startNs / frameNs) * width;
+        float x1 = origin.x + (float)((double)endNs / frameNs) * width;
+        float y0 = origin.y + (laneFirstRows[lane] + event.depth) * FLAME_ROW_HEIGHT;
+        ImVec2 p0(x0, y0);
+        ImVec2 p1(std::max(x1, x0 + 1.0f), y0 + FLAME_ROW_HEIGHT - 1.0f);
+        drawList->AddRectFilled(p0, p1, getZoneColor(event.zone));
+
+        char label[64];
+        snprintf(label, sizeof(label), "%s %.2f ms", CPU_ZONE_NAMES[static_cast<int>(event.zone)], toMilliseconds(event.endNs - event.startNs));
+        if (ImGui::CalcTextSize(label).x < p1.x - p0.x - 4.0f)
+        {
+            drawList->AddText(ImVec2(p0.x + 2.0f, p0.y + 2.0f), IM_COL32(0, 0, 0, 255), label);
+        }
+        if (ImGui::IsMouseHoveringRect(p0, p1))
+        {
+            ImGui::SetTooltip("%s", label);
+        }
+    }
+    ImGui::Dummy(ImVec2(width, flameHeight));
+    if (laneThreads.size() > 1)
+    {
+        ImGui::Text("Lanes below the line are other threads, e.g. the simulation thread.");
+    }
+}
+
+void ProfilerUI::drawTraceControls()
+{
+    ImGui::Text("Trace:");
+
+    bool isRecording = TraceRecorder::isEnabled();
+    if (ImGui::Checkbox("Record trace", &isRecording))
+    {
+        if (isRecording)
+        {
+            TraceRecorder::calibrateGpuClock();
+        }
+        TraceRecorder::setEnabled(isRecording);
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Save trace"))
+    {
+        std::wstring filepath = WindowsFileDialog::SaveFileDialog(L"Chrome trace (*.json)\0*.json\0All Files\0*.*\0");
+        if (filepath.size() > 0)
+        {
+            TraceRecorder::save(filepath);
+        }
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Clear trace"))
+    {
+        TraceRecorder::clear();
+    }
+
+    ImGui::Text("Events: %d / %d, dropped: %llu", TraceRecorder::getEventCount(), TraceRecorder::MAX_EVENTS, (unsigned long long)TraceRecorder::getDroppedCount());
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+// ProfilerUI class for drawing the contents of the performance tab
+class ProfilerUI
+{
+public:
+    ProfilerUI() = delete;
+
+    static void drawGpuStatistics();
+    static void drawCpuTimeline();
+    static void drawTraceControls();
+};
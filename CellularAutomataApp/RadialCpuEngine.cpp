@@ -0,0 +1,163 @@
+#include "RadialCpuEngine.h"
+#include <math.h>
+#include "ThreadPool.h"
+
+EngineType RadialCpuEngine::getType() const
+{
+    return EngineType::RadialCpu;
+}
+
+bool RadialCpuEngine::supports(const SimulationRules& rules) const
+{
+    return rules.isRadiallySymmetric();
+}
+
+void RadialCpuEngine::setRules(const SimulationRules& rules)
+{
+    radialKernel = RadialKernel::compile(rules);
+    sparseKernel = SparseKernel::compile(rules);
+    ranges.set(rules);
+    isExact = sparseKernel.fixedPoint.isValid();
+
+    // Sequential float summation of n terms is off by at most n * u / (1 - n * u) times the sum of their magnitudes
+    double absoluteSum = 0.0;
+    for (const KernelTapGroup& group : sparseKernel.groups)
+    {
+        absoluteSum += fabs((double)group.weight) * group.tapCount;
+    }
+    double n = (double)sparseKernel.taps.size();
+    double u = ldexp(1.0, -24);
+    maxSumError = 2.0 * n * u / (1.0 - n * u) * absoluteSum + 1e-9; // Doubled for the disc sums themselves
+}
+
+void RadialCpuEngine::step(CpuWorld& world)
+{
+    const int w = world.width;
+    const int h = world.height;
+    const int range = radialKernel.neighborSearchRange;
+    const int diameter = range * 2 + 1;
+
+    // Columns from -range - 1 to w + range - 1, the leaving edge is one column left of the disc
+    const int offset = range + 1;
+    const int paddedWidth = w + 2 * range + 1;
+
+    const uint8_t* current = world.cells.data();
+    uint8_t* next = world.getScratch();
+
+    paddedCells.resize((size_t)paddedWidth * h);
+    ThreadPool::parallelFor(0, h, [&](int rowBegin, int rowEnd)
+        {
+            for (int y = rowBegin; y < rowEnd; ++y)
+            {
+                const uint8_t* source = current + (size_t)y * w;
+                uint8_t* padded = paddedCells.data() + (size_t)y * paddedWidth;
+                for (int i = 0; i < paddedWidth; ++i)
+                {
+                    padded[i] = source[((i - offset) % w + w) % w];
+                }
+            }
+        });
+
+    const std::vector<RadialDisc>& discs = radialKernel.discs;
+    const double thresholds[] = { ranges.birthMin, ranges.birthMax, ranges.stableMin, ranges.stableMax };
+
+    ThreadPool::parallelFor(0, h, [&](int rowBegin, int rowEnd)
+        {
+            // columnTotals[k][c] is the number of alive cells among the first k window rows in padded column c
+            std::vector<uint8_t> columnTotals((size_t)(diameter + 1) * paddedWidth);
+            std::vector<int> discCounts(discs.size());
+            std::vector<const uint8_t*> rows(diameter);
+
+            auto countRun = [&](const RadialRun& run, int column)
+                {
+                    return columnTotals[(size_t)(run.lastRow + 1) * paddedWidth + column] - columnTotals[(size_t)run.firstRow * paddedWidth + column];
+                };
+
+            for (int y = rowBegin; y < rowEnd; ++y)
+            {
+                for (int k = 0; k < diameter; ++k)
+                {
+                    rows[k] = paddedCells.data() + (size_t)(((y + k - range) % h + h) % h) * paddedWidth;
+
+                    const uint8_t* previousTotals = columnTotals.data() + (size_t)k * paddedWidth;
+                    uint8_t* totals = columnTotals.data() + (size_t)(k + 1) * paddedWidth;
+                    for (int c = 0; c < paddedWidth; ++c)
+                    {
+                        totals[c] = previousTotals[c] + rows[k][c];
+                    }
+                }
+
+                for (int x = 0; x < w; ++x)
+                {
+                    double sum = 0.0;
+                    for (size_t i = 0; i < discs.size(); ++i)
+                    {
+                        const RadialDisc& disc = discs[i];
+                        if (x == 0)
+                        {
+                            discCounts[i] = 0;
+                            for (const RadialRun& run : disc.columnRuns)
+                            {
+                                discCounts[i] += countRun(run, offset + run.dx);
+                            }
+                        }
+                        else
+                        {
+                            for (const RadialRun& run : disc.enteringRuns)
+                            {
+                                discCounts[i] += countRun(run, offset + x + run.dx);
+                            }
+                            for (const RadialRun& run : disc.leavingRuns)
+                            {
+                                discCounts[i] -= countRun(run, offset + x + run.dx);
+                            }
+                        }
+                        sum += disc.coefficient * discCounts[i];
+                    }
+
+                    bool isAmbiguous = false;
+                    if (!isExact)
+                    {
+                        for (double threshold : thresholds)
+                        {
+                            isAmbiguous |= fabs(sum - threshold) <= maxSumError;
+                        }
+                    }
+
+                    uint8_t cell = current[(size_t)y * w + x];
+                    if (!isAmbiguous)
+                    {
+                        if (sum >= ranges.birthMin && sum <= ranges.birthMax)
+                        {
+                            next[(size_t)y * w + x] = 1;
+                        }
+                        else if (sum >= ranges.stableMin && sum <= ranges.stableMax)
+                        {
+                            next[(size_t)y * w + x] = cell;
+                        }
+                        else
+                        {
+                            next[(size_t)y * w + x] = 0;
+                        }
+                        continue;
+                    }
+
+                    // Close to a limit, sum the taps in shader order
+                    float floatSum = 0.0f;
+                    for (const KernelTapGroup& group : sparseKernel.groups)
+                    {
+                        int count = 0;
+                        for (int i = group.firstTap; i < group.firstTap + group.tapCount; ++i)
+                        {
+                            const KernelTap& tap = sparseKernel.taps[i];
+                            count += rows[tap.dy + range][offset + x + tap.dx];
+                        }
+                        floatSum += float(count) * group.weight;
+                    }
+                    next[(size_t)y * w + x] = ranges.apply(cell, floatSum);
+                }
+            }
+        });
+
+    world.swapBuffers();
+}
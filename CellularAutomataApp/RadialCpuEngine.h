@@ -0,0 +1,25 @@
+#pragma once
+#include "CpuEngine.h"
+#include "RadialKernel.h"
+#include "SparseKernel.h"
+
+// RadialCpuEngine class for radially symmetric kernels such as the filled circles.
+// Every output row builds running column totals of its window rows, then slides the disc counts of
+// RadialKernel along the row, so a cell costs the edge runs of the discs instead of every tap.
+// Disc sums are not added in shader order, so cells whose sum is within the float rounding bound of a
+// range limit are summed again tap by tap in shader order, which keeps the result exact.
+class RadialCpuEngine : public CpuEngine
+{
+public:
+    EngineType getType() const override;
+    bool supports(const SimulationRules& rules) const override;
+    void setRules(const SimulationRules& rules) override;
+    void step(CpuWorld& world) override;
+private:
+    RadialKernel radialKernel;
+    SparseKernel sparseKernel;
+    TransitionRanges ranges;
+    bool isExact = false;     // Fixed-point kernels have exact sums in any order
+    double maxSumError = 0.0; // Bound of the shader float sum error
+    std::vector<uint8_t> paddedCells;
+};
@@ -0,0 +1,116 @@
+#include "RadialKernel.h"
+#include <algorithm>
+#include <map>
+
+// Groups consecutive window rows with the same column offset into runs, rows with no cells are skipped
+static std::vector<RadialRun> createEdgeRuns(const std::vector<int>& halfWidths, bool isEntering)
+{
+    std::vector<RadialRun> runs;
+    for (int row = 0; row < (int)halfWidths.size(); ++row)
+    {
+        int halfWidth = halfWidths[row];
+        if (halfWidth < 0)
+        {
+            continue;
+        }
+
+        int dx = isEntering ? halfWidth : -halfWidth - 1;
+        if (!runs.empty() && runs.back().dx == dx && runs.back().lastRow == row - 1)
+        {
+            runs.back().lastRow = row;
+        }
+        else
+        {
+            RadialRun run;
+            run.dx = dx;
+            run.firstRow = row;
+            run.lastRow = row;
+            runs.push_back(run);
+        }
+    }
+    return runs;
+}
+
+RadialKernel RadialKernel::compile(const SimulationRules& rules)
+{
+    RadialKernel radial;
+    int range = rules.neighborSearchRange;
+    int diameter = range * 2 + 1;
+    radial.neighborSearchRange = range;
+
+    std::map<int, float> weights; // Squared distance -> weight
+    for (int y = 0; y < diameter; ++y)
+    {
+        for (int x = 0; x < diameter; ++x)
+        {
+            int dx = x - range;
+            int dy = y - range;
+            weights[dx * dx + dy * dy] = rules.kernel[y * diameter + x];
+        }
+    }
+
+    for (auto it = weights.begin(); it != weights.end(); ++it)
+    {
+        auto next = std::next(it);
+        double nextWeight = next != weights.end() ? (double)next->second : 0.0;
+        double coefficient = (double)it->second - nextWeight;
+        if (coefficient == 0.0)
+        {
+            continue;
+        }
+
+        RadialDisc disc;
+        disc.maxDistanceSquared = it->first;
+        disc.coefficient = coefficient;
+
+        // Half width of the disc in every window row, -1 for rows outside of it
+        std::vector<int> halfWidths(diameter, -1);
+        for (int row = 0; row < diameter; ++row)
+        {
+            int dy = row - range;
+            for (int dx = range; dx >= 0; --dx)
+            {
+                if (dx * dx + dy * dy <= disc.maxDistanceSquared)
+                {
+                    halfWidths[row] = dx;
+                    break;
+                }
+            }
+        }
+
+        // Every column of a disc is an interval too
+        for (int dx = -range; dx <= range; ++dx)
+        {
+            RadialRun run;
+            run.dx = dx;
+            run.firstRow = -1;
+            for (int row = 0; row < diameter; ++row)
+            {
+                if (halfWidths[row] >= std::abs(dx))
+                {
+                    run.firstRow = run.firstRow < 0 ? row : run.firstRow;
+                    run.lastRow = row;
+                }
+            }
+            if (run.firstRow >= 0)
+            {
+                disc.columnRuns.push_back(run);
+            }
+        }
+
+        disc.enteringRuns = createEdgeRuns(halfWidths, true);
+        disc.leavingRuns = createEdgeRuns(halfWidths, false);
+        radial.discs.push_back(disc);
+    }
+    return radial;
+}
+
+int RadialKernel::getSlideWork() const
+{
+    int work = 0;
+    for (const RadialDisc& disc : discs)
+    {
+        work += (int)(disc.enteringRuns.size() + disc.leavingRuns.size());
+    }
+    return work;
+}
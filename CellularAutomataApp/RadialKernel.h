@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+#include "SimulationRules.h"
+
+// Vertical run of cells in one column of the (2r+1) window rows
+struct RadialRun
+{
+    int dx = 0;
+    int firstRow = 0;
+    int lastRow = 0;
+};
+
+// Cells within a squared distance, clipped to the kernel square. Every row of a disc is an interval,
+// so sliding it one cell to the right only adds its right edge and removes the column left of its left edge.
+struct RadialDisc
+{
+    int maxDistanceSquared = 0;
+    double coefficient = 0.0;           // Weight of this disc minus the weight of the next larger one
+    std::vector<RadialRun> columnRuns;   // Whole disc, for the first cell of a row
+    std::vector<RadialRun> enteringRuns; // Right edge at the new position
+    std::vector<RadialRun> leavingRuns;  // Column left of the left edge at the new position
+};
+
+// RadialKernel struct, a radially symmetric kernel written as a sum of disc counts.
+// With rings of equal weight ring = disc - previous disc, the sum of weight * ring count becomes
+// the sum of (weight - next weight) * disc count, and discs whose coefficient is 0 drop out.
+struct RadialKernel
+{
+    int neighborSearchRange = 1;
+    std::vector<RadialDisc> discs;
+
+    static RadialKernel compile(const SimulationRules& rules); // Expects rules.isRadiallySymmetric()
+
+    int getSlideWork() const; // Runs added or removed per cell
+};
@@ -13,6 +13,11 @@ int Random::Int(int min, int max)
     return dist(Random::GetEngine());
 }
 
+void Random::Seed(unsigned int seed)
+{
+    GetEngine().seed(seed);
+}
+
 float Random::Float(float min, float max)
 {
     std::uniform_real_distribution<float> dist(min, max);
@@ -1,3 +1,4 @@
+#pragma once
 #include <random>
 
 class Random {
@@ -6,6 +7,7 @@ public:
 
     static int Int(int min, int max);
     static float Float(float min, float max);
+    static void Seed(unsigned int seed);
 private:
     static std::mt19937& GetEngine();
 };
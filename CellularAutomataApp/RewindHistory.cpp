@@ -0,0 +1,327 @@
+#include "RewindHistory.h"
+#include <algorithm>
+#include <cstring>
+#include "TraceRecorder.h"
+
+const size_t MAX_PENDING_FRAMES = 4;
+const size_t MIN_ZERO_RUN = 4; // Shorter runs of zero bytes stay in the literals
+
+static void writeVarint(std::vector<uint8_t>& output, size_t value)
+{
+    while (value >= 0x80)
+    {
+        output.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    output.push_back((uint8_t)value);
+}
+
+static size_t readVarint(const uint8_t*& input)
+{
+    size_t value = 0;
+    for (int shift = 0;; shift += 7)
+    {
+        uint8_t byte = *input++;
+        value |= (size_t)(byte & 0x7F) << shift;
+        if (byte < 0x80)
+        {
+            return value;
+        }
+    }
+}
+
+// Pairs of (zero bytes count, literal bytes count) followed by the literal bytes
+static void encodeZeroRuns(const uint8_t* bytes, size_t size, std::vector<uint8_t>& output)
+{
+    output.clear();
+    size_t i = 0;
+    while (i < size)
+    {
+        size_t zerosBegin = i;
+        while (i < size && bytes[i] == 0)
+        {
+            i++;
+        }
+
+        size_t literalsBegin = i;
+        size_t zerosInRow = 0;
+        while (i < size && zerosInRow < MIN_ZERO_RUN)
+        {
+            zerosInRow = bytes[i] == 0 ? zerosInRow + 1 : 0;
+            i++;
+        }
+        if (zerosInRow == MIN_ZERO_RUN)
+        {
+            i -= zerosInRow;
+        }
+
+        writeVarint(output, literalsBegin - zerosBegin);
+        writeVarint(output, i - literalsBegin);
+        output.insert(output.end(), bytes + literalsBegin, bytes + i);
+    }
+}
+
+// XORs the encoded bytes into target, a zeroed target gets the bytes themselves
+static void applyZeroRuns(const std::vector<uint8_t>& encoded, uint8_t* target)
+{
+    const uint8_t* input = encoded.data();
+    const uint8_t* end = input + encoded.size();
+    size_t position = 0;
+    while (input < end)
+    {
+        position += readVarint(input);
+        size_t literalsCount = readVarint(input);
+        for (size_t i = 0; i < literalsCount; ++i)
+        {
+            target[position + i] ^= input[i];
+        }
+        input += literalsCount;
+        position += literalsCount;
+    }
+}
+
+RewindHistory::RewindHistory(int width, int height, size_t budgetBytes)
+    : width(width), height(height), packedBytes(((size_t)width * height + 7) / 8), budgetBytes(budgetBytes),
+    framePool((size_t)width * height)
+{
+    worker = std::thread([this]() { workerLoop(); });
+}
+
+RewindHistory::~RewindHistory()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+    pendingCondition.notify_all();
+    worker.join();
+
+    for (const PendingFrame& frame : pendingFrames)
+    {
+        framePool.deallocate(frame.cells);
+    }
+}
+
+void RewindHistory::push(const ReadbackFrame& frame)
+{
+    if (frame.width != width || frame.height != height)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (isRestoredGenerationSkipped && frame.generation == restoredGeneration)
+        {
+            return;
+        }
+        isRestoredGenerationSkipped = false;
+
+        // The worker is behind, the frame is lost rather than queueing without bound
+        if (pendingFrames.size() >= MAX_PENDING_FRAMES)
+        {
+            droppedFrames++;
+            return;
+        }
+    }
+
+    PendingFrame pending;
+    pending.generation = frame.generation;
+    pending.cells = static_cast<uint8_t*>(framePool.allocate());
+    memcpy(pending.cells, frame.data, (size_t)width * height);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingFrames.push_back(pending);
+    }
+    pendingCondition.notify_one();
+}
+
+void RewindHistory::workerLoop()
+{
+    TraceRecorder::setThreadName("Rewind history");
+    while (true)
+    {
+        PendingFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            pendingCondition.wait(lock, [this]() { return isStopping || !pendingFrames.empty(); });
+            if (isStopping)
+            {
+                return;
+            }
+            frame = pendingFrames.front();
+            pendingFrames.pop_front();
+        }
+
+        addRecord(frame);
+        framePool.deallocate(frame.cells);
+    }
+}
+
+void RewindHistory::addRecord(const PendingFrame& frame)
+{
+    ScopedTraceEvent trace("Rewind capture", "history");
+
+    packed.assign(packedBytes, 0);
+    size_t cellsCount = (size_t)width * height;
+    for (size_t i = 0; i < cellsCount; ++i)
+    {
+        packed[i >> 3] |= (uint8_t)((frame.cells[i] & 1) << (i & 7));
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // Records after the frame belong to a timeline that was left by restoring an older generation
+    bool isTruncated = false;
+    while (!groups.empty() && groups.back().back().generation >= frame.generation)
+    {
+        usedBytes -= groups.back().back().data.size();
+        groups.back().pop_back();
+        if (groups.back().empty())
+        {
+            groups.pop_back();
+        }
+        isTruncated = true;
+    }
+
+    bool isKeyframe = isTruncated || groups.empty() || groups.back().size() >= KEYFRAME_INTERVAL;
+    lock.unlock();
+
+    Record record;
+    record.generation = frame.generation;
+    if (isKeyframe)
+    {
+        encodeZeroRuns(packed.data(), packedBytes, record.data);
+    }
+    else
+    {
+        for (size_t i = 0; i < packedBytes; ++i)
+        {
+            previousPacked[i] ^= packed[i];
+        }
+        encodeZeroRuns(previousPacked.data(), packedBytes, record.data);
+    }
+    record.data.shrink_to_fit();
+    previousPacked.swap(packed);
+
+    lock.lock();
+    usedBytes += record.data.size();
+    if (isKeyframe)
+    {
+        groups.emplace_back();
+    }
+    groups.back().push_back(std::move(record));
+    trimToBudget();
+}
+
+void RewindHistory::trimToBudget()
+{
+    // The newest group is kept whatever its size, deltas need their keyframe
+    while (usedBytes > budgetBytes && groups.size() > 1)
+    {
+        for (const Record& record : groups.front())
+        {
+            usedBytes -= record.data.size();
+        }
+        groups.pop_front();
+    }
+}
+
+bool RewindHistory::findRecord(int index, size_t& groupIndex, size_t& recordIndex) const
+{
+    if (index < 0)
+    {
+        return false;
+    }
+    for (groupIndex = 0; groupIndex < groups.size(); ++groupIndex)
+    {
+        if ((size_t)index < groups[groupIndex].size())
+        {
+            recordIndex = (size_t)index;
+            return true;
+        }
+        index -= (int)groups[groupIndex].size();
+    }
+    return false;
+}
+
+int RewindHistory::getRecordsCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (const auto& group : groups)
+    {
+        count += group.size();
+    }
+    return (int)count;
+}
+
+uint64_t RewindHistory::getGeneration(int index) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t groupIndex = 0;
+    size_t recordIndex = 0;
+    return findRecord(index, groupIndex, recordIndex) ? groups[groupIndex][recordIndex].generation : 0;
+}
+
+bool RewindHistory::getCells(int index, std::vector<uint8_t>& cells, uint64_t& generation) const
+{
+    ScopedTraceEvent trace("Rewind restore", "history");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t groupIndex = 0;
+    size_t recordIndex = 0;
+    if (!findRecord(index, groupIndex, recordIndex))
+    {
+        return false;
+    }
+
+    // The keyframe and every delta up to the record
+    std::vector<uint8_t> state(packedBytes, 0);
+    const std::vector<Record>& group = groups[groupIndex];
+    generation = group[recordIndex].generation;
+    for (size_t i = 0; i <= recordIndex; ++i)
+    {
+        applyZeroRuns(group[i].data, state.data());
+    }
+
+    size_t cellsCount = (size_t)width * height;
+    cells.resize(cellsCount);
+    for (size_t i = 0; i < cellsCount; ++i)
+    {
+        cells[i] = (state[i >> 3] >> (i & 7)) & 1;
+    }
+    return true;
+}
+
+void RewindHistory::markRestored(uint64_t generation)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    isRestoredGenerationSkipped = true;
+    restoredGeneration = generation;
+}
+
+void RewindHistory::setBudget(size_t budgetBytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->budgetBytes = budgetBytes;
+    trimToBudget();
+}
+
+size_t RewindHistory::getBudget() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return budgetBytes;
+}
+
+size_t RewindHistory::getUsedBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return usedBytes;
+}
+
+uint64_t RewindHistory::getDroppedFrames() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return droppedFrames;
+}
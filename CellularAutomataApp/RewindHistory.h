@@ -0,0 +1,82 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "FixedBlockPool.h"
+#include "TextureReadback.h"
+
+// RewindHistory class, a bounded history of the generations delivered by TextureReadback.
+// Cells are packed to one bit each; every KEYFRAME_INTERVAL-th record is a keyframe, the others are the
+// XOR with the previous record. Both are stored as runs of zero bytes and literal bytes, so still
+// regions cost almost nothing. Frames are only copied in push(), packing and compression run on a
+// worker thread. When the history grows over the budget the oldest keyframe and its deltas are dropped.
+// Only generations that were read back are kept, at high update rates some generations are skipped.
+class RewindHistory
+{
+public:
+    static const int KEYFRAME_INTERVAL = 32;
+
+    RewindHistory(int width, int height, size_t budgetBytes);
+    ~RewindHistory();
+    RewindHistory(const RewindHistory&) = delete;
+    RewindHistory& operator=(const RewindHistory&) = delete;
+
+    // Newer records than the frame are from an abandoned timeline and are dropped
+    void push(const ReadbackFrame& frame);
+
+    // Records are indexed from the oldest one
+    int getRecordsCount() const;
+    uint64_t getGeneration(int index) const;
+    bool getCells(int index, std::vector<uint8_t>& cells, uint64_t& generation) const; // Both from the same record
+
+    // Frames of this generation are ignored until another one arrives, so restoring it keeps the newer records
+    void markRestored(uint64_t generation);
+
+    void setBudget(size_t budgetBytes);
+    size_t getBudget() const;
+    size_t getUsedBytes() const;
+    uint64_t getDroppedFrames() const;
+private:
+    struct Record
+    {
+        uint64_t generation = 0;
+        std::vector<uint8_t> data; // Zero runs over the packed cells, XOR with the previous record for deltas
+    };
+
+    struct PendingFrame
+    {
+        uint64_t generation = 0;
+        uint8_t* cells = nullptr;
+    };
+
+    int width;
+    int height;
+    size_t packedBytes;
+
+    mutable std::mutex mutex;
+    std::deque<std::vector<Record>> groups; // Keyframe first
+    size_t usedBytes = 0;
+    size_t budgetBytes;
+    uint64_t droppedFrames = 0;
+    bool isRestoredGenerationSkipped = false;
+    uint64_t restoredGeneration = 0;
+
+    // Frames waiting for the worker
+    FixedBlockPool framePool;
+    std::deque<PendingFrame> pendingFrames;
+    std::condition_variable pendingCondition;
+    bool isStopping = false;
+    std::thread worker;
+
+    // Worker state, the packed cells of the newest record
+    std::vector<uint8_t> previousPacked;
+    std::vector<uint8_t> packed;
+
+    void workerLoop();
+    void addRecord(const PendingFrame& frame);
+    void trimToBudget();
+    bool findRecord(int index, size_t& groupIndex, size_t& recordIndex) const;
+};
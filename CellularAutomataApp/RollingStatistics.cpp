@@ -0,0 +1,54 @@
+#include "RollingStatistics.h"
+#include <algorithm>
+
+RollingStatistics::RollingStatistics(int capacity)
+    : capacity(std::max(capacity, 1))
+{
+    samples.reserve(this->capacity);
+}
+
+void RollingStatistics::add(double value)
+{
+    if ((int)samples.size() < capacity)
+    {
+        samples.push_back(value);
+    }
+    else
+    {
+        samples[nextIndex] = value;
+    }
+    nextIndex = (nextIndex + 1) % capacity;
+    last = value;
+}
+
+void RollingStatistics::clear()
+{
+    samples.clear();
+    nextIndex = 0;
+    last = 0.0;
+}
+
+RollingStatistics::Summary RollingStatistics::getSummary() const
+{
+    Summary summary;
+    if (samples.empty())
+    {
+        return summary;
+    }
+
+    std::vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0.0;
+    for (double value : sorted)
+    {
+        total += value;
+    }
+
+    summary.count = (int)sorted.size();
+    summary.last = last;
+    summary.mean = total / sorted.size();
+    summary.p50 = sorted[(sorted.size() - 1) / 2];
+    summary.p99 = sorted[(sorted.size() - 1) * 99 / 100];
+    return summary;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+
+// RollingStatistics class for keeping the most recent samples of a measurement
+class RollingStatistics
+{
+public:
+    struct Summary
+    {
+        int count = 0;
+        double last = 0.0;
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p99 = 0.0;
+    };
+
+    explicit RollingStatistics(int capacity = 240);
+
+    void add(double value);
+    void clear();
+    Summary getSummary() const;
+private:
+    std::vector<double> samples;
+    int capacity;
+    int nextIndex = 0;
+    double last = 0.0;
+};
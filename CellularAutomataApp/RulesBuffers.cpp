@@ -0,0 +1,67 @@
+#include "RulesBuffers.h"
+#include <vector>
+#include "SparseKernel.h"
+
+RulesBuffers::RulesBuffers()
+{
+    glGenBuffers(1, &tapsSSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, tapsSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, 441 * sizeof(KernelTap), nullptr, GL_DYNAMIC_DRAW); // 441 is number of cells with kernel radius 10
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, tapsSSBO); // binding = 2
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glGenBuffers(1, &tapGroupsSSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, tapGroupsSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, 441 * sizeof(KernelTapGroup), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, tapGroupsSSBO); // binding = 3
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // Resized with the table of every fixed-point kernel
+    glGenBuffers(1, &transitionsSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, transitionsSSBO); // binding = 4
+}
+
+RulesBuffers::~RulesBuffers()
+{
+    glDeleteBuffers(1, &tapsSSBO);
+    glDeleteBuffers(1, &tapGroupsSSBO);
+    glDeleteBuffers(1, &transitionsSSBO);
+}
+
+void RulesBuffers::submit(const SimulationRules& rules, Shader& computeShader)
+{
+    rules.submitToShader(computeShader);
+
+    // Only the non-zero taps are read, zero weights never reach the shader
+    SparseKernel sparseKernel = SparseKernel::compile(rules);
+    computeShader.setInt("tapGroupCount", (int)sparseKernel.groups.size());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, tapsSSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sparseKernel.taps.size() * sizeof(KernelTap), sparseKernel.taps.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, tapGroupsSSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sparseKernel.groups.size() * sizeof(KernelTapGroup), sparseKernel.groups.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // Kernels with an exact fixed-point form are summed with integers
+    const FixedPointRules& fixedPoint = sparseKernel.fixedPoint;
+    computeShader.setInt("kernelDenominator", fixedPoint.denominator);
+    if (fixedPoint.isValid())
+    {
+        const TransitionTable& transitions = fixedPoint.transitions;
+        computeShader.setInt("transitionMinSum", transitions.minSum);
+        computeShader.setInt("transitionSumsCount", transitions.sumsCount);
+
+        std::vector<GLuint> nextStates(transitions.nextStates.begin(), transitions.nextStates.end());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, transitionsSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, nextStates.size() * sizeof(GLuint), nextStates.data(), GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, transitionsSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+}
+
+void RulesBuffers::bind() const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, tapsSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, tapGroupsSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, transitionsSSBO);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <glad/glad.h>
+#include "Shader.h"
+#include "SimulationRules.h"
+
+// RulesBuffers class for the storage buffers Shaders/automata.comp reads the compiled rules from:
+// the sparse kernel taps (binding 2), their weight groups (binding 3) and the transition table (binding 4).
+class RulesBuffers
+{
+public:
+    RulesBuffers();
+    ~RulesBuffers();
+    RulesBuffers(const RulesBuffers&) = delete;
+    RulesBuffers& operator=(const RulesBuffers&) = delete;
+
+    void submit(const SimulationRules& rules, Shader& computeShader); // Also sets the rule uniforms
+    void bind() const;
+private:
+    GLuint tapsSSBO;
+    GLuint tapGroupsSSBO;
+    GLuint transitionsSSBO;
+};
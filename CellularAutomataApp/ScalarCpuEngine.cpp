@@ -0,0 +1,62 @@
+#include "ScalarCpuEngine.h"
+#include "ThreadPool.h"
+
+EngineType ScalarCpuEngine::getType() const
+{
+    return EngineType::ScalarCpu;
+}
+
+void ScalarCpuEngine::setRules(const SimulationRules& rules)
+{
+    kernel = SparseKernel::compile(rules);
+    ranges.set(rules);
+}
+
+void ScalarCpuEngine::step(CpuWorld& world)
+{
+    const int w = world.width;
+    const int h = world.height;
+    const int range = kernel.neighborSearchRange;
+    const int diameter = range * 2 + 1;
+
+    // Wrapped column of every x in [-range, w + range)
+    std::vector<int> columns(w + 2 * range);
+    for (int i = 0; i < (int)columns.size(); ++i)
+    {
+        columns[i] = ((i - range) % w + w) % w;
+    }
+
+    const uint8_t* current = world.cells.data();
+    uint8_t* next = world.getScratch();
+
+    ThreadPool::parallelFor(0, h, [&](int rowBegin, int rowEnd)
+        {
+            std::vector<const uint8_t*> rows(diameter);
+            for (int y = rowBegin; y < rowEnd; ++y)
+            {
+                for (int dy = -range; dy <= range; ++dy)
+                {
+                    rows[dy + range] = current + (size_t)(((y + dy) % h + h) % h) * w;
+                }
+
+                for (int x = 0; x < w; ++x)
+                {
+                    float sum = 0.0f;
+                    for (const KernelTapGroup& group : kernel.groups)
+                    {
+                        int count = 0;
+                        for (int i = group.firstTap; i < group.firstTap + group.tapCount; ++i)
+                        {
+                            const KernelTap& tap = kernel.taps[i];
+                            count += rows[tap.dy + range][columns[x + tap.dx + range]];
+                        }
+                        sum += float(count) * group.weight;
+                    }
+
+                    next[(size_t)y * w + x] = ranges.apply(current[(size_t)y * w + x], sum);
+                }
+            }
+        });
+
+    world.swapBuffers();
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "CpuEngine.h"
+#include "SparseKernel.h"
+
+// ScalarCpuEngine class, a direct port of Shaders/automata.comp used as the CPU reference.
+// Rows are split between threads, every cell sums the tap groups of the sparse kernel in shader order.
+class ScalarCpuEngine : public CpuEngine
+{
+public:
+    EngineType getType() const override;
+    void setRules(const SimulationRules& rules) override;
+    void step(CpuWorld& world) override;
+private:
+    SparseKernel kernel;
+    TransitionRanges ranges;
+};
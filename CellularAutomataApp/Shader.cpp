@@ -2,9 +2,17 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include "TraceRecorder.h"
 
 Shader::Shader(const std::vector<ShaderSource>& sources)
 {
+    std::string paths;
+    for (const auto& src : sources)
+    {
+        paths += paths.empty() ? src.path : ", " + src.path;
+    }
+    ScopedTraceEvent trace("Shader compile", "gl", paths);
+
     std::vector<GLuint> shaderIDs;
     for (const auto& src : sources)
     {
@@ -84,6 +92,11 @@ void Shader::setUvec2(const std::string& name, unsigned int x, unsigned int y) c
 	glUniform2ui(getUniformLocation(name), x, y);
 }
 
+void Shader::setIvec2(const std::string& name, int x, int y) const
+{
+    glUniform2i(getUniformLocation(name), x, y);
+}
+
 std::string Shader::loadShaderSource(const std::string& filePath) const
 {
     std::ifstream file(filePath);
@@ -25,6 +25,7 @@ public:
     void setVec3(const std::string& name, float x, float y, float z) const;
     void setMat4(const std::string& name, const float* mat) const;
 	void setUvec2(const std::string& name, unsigned int x, unsigned int y) const;
+    void setIvec2(const std::string& name, int x, int y) const;
 
     GLuint getID() const { return ID; }
 
@@ -1,291 +1,214 @@
 #include "Simulation.h"
 #include <glad/glad.h>
 #include <math.h>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include "Random.h"
 
 const int WORK_GROUP_W = 8;
 const int WORK_GROUP_H = 8;
+const double ENGINE_RESELECTION_SECONDS = 2.0; // Of stepping, a paused simulation keeps its engine
+const int MAX_TIMED_GENERATIONS = 16; // Per step() call, so fast-forward does not flood the GPU timer
+const int MAX_ADVANCE_BATCH = 1 << 16;
+const double MAX_BACKLOG_SECONDS = 0.5; // Generations owed beyond this are dropped instead of caught up
+const double UPDATES_RATE_WINDOW_SECONDS = 0.5;
 
 
-SimulationRules::SimulationRules()
-{
-    int maxDiameter = MAX_NEIGHBOR_SEARCH_RANGE * 2 + 1;
-    int maxTotalCells = maxDiameter * maxDiameter;
-    kernel.reserve(maxTotalCells);
-
-    int diameter = neighborSearchRange * 2 + 1;
-    int totalCells = diameter * diameter;
-	kernel.resize(totalCells, 1.0f);
-
-	kernel[neighborSearchRange + neighborSearchRange * diameter] = 0.0f; // Center cell should not contribute to the sum
-}
-
-void SimulationRules::submitToShader(Shader& shader) const
+void SimulationVisuals::submitToShader(Shader& shader) const
 {
     shader.use();
-    shader.setInt("neighborSearchRange", neighborSearchRange);
-    shader.setUvec2("stableRange", stableRange[0], stableRange[1]);
-    shader.setUvec2("birthRange", birthRange[0], birthRange[1]);
+    shader.setVec3("aliveCellColor", aliveColor[0], aliveColor[1], aliveColor[2]);
+    shader.setVec3("deadCellColor", deadColor[0], deadColor[1], deadColor[2]);
 }
 
-float SimulationRules::getMaxNeighborSum() const
+Simulation::Simulation(int gridW, int gridH, Texture2D& texA, Texture2D& texB)
+    : gridW(gridW), gridH(gridH), textureA(texA), textureB(texB), gen(rd()), dis(0, 1), computeTimer(GpuZone::SimulationStep)
 {
-	float maxSum = 0.0f;
+    std::vector<Shader::ShaderSource> sources = {
+        { GL_COMPUTE_SHADER, "Shaders/automata.comp" }
+    };
+    computeShader = std::make_unique<Shader>(sources);
+    computeShader->use();
+    computeShader->setInt("gridWidth", gridW);
+    computeShader->setInt("gridHeight", gridH);
 
-	int diameter = neighborSearchRange * 2 + 1;
+    groupsX = ceilf((float)gridW / (float)WORK_GROUP_W);
+    groupsY = ceilf((float)gridH / (float)WORK_GROUP_H);
 
-    for (int r = 0; r < diameter; ++r)
+    for (int i = 0; i < static_cast<int>(EngineType::COUNT_); ++i)
     {
-        for (int c = 0; c < diameter; ++c)
+        std::unique_ptr<CpuEngine> engine = CpuEngine::create(static_cast<EngineType>(i));
+        if (engine)
         {
-            int index = r * diameter + c;
-			float value = kernel[index];
-            if (value > 0.0f)
-            {
-				maxSum += value;
-            }
+            cpuEngines.push_back(std::move(engine));
         }
-	}
+    }
+    cpuWorld.resize(gridW, gridH);
 
-    return maxSum;
+    randomize();
+    submitRulesToShader();
 }
 
-void SimulationRules::updateKernelSize()
+void Simulation::randomize()
 {
-    if (neighborSearchRange != previousNeighborSearchRange)
+    std::vector<uint8_t> data(gridW * gridH);
+    for (int i = 0; i < gridW * gridH; ++i)
     {
-        int diameter = neighborSearchRange * 2 + 1;
-        int totalCells = diameter * diameter;
-		kernel.resize(totalCells, 1.0f);
+        data[i] = static_cast<uint8_t>(dis(gen));
     }
-	previousNeighborSearchRange = neighborSearchRange;
+    setCells(data);
 }
 
-void SimulationRules::randomizeKernel()
+void Simulation::setCells(const std::vector<uint8_t>& cells)
 {
-    if (kernelRandomizationType == KernelGenerationType::RandomAllValues)
-    {
-        const float leftBorder = 0.2f;
-        const float rightBorder = 0.8f;
-
-        for (int i = 0; i < kernel.size(); ++i)
-        {
-            float value = Random::Float(0.0f, 1.0f);
-
-            if (value < leftBorder)
-            {
-                // Scale to [SimulationRules::KERNEL_MIN_VALUE, 1]
-                value = SimulationRules::KERNEL_MIN_VALUE + value / leftBorder * (1.0f - SimulationRules::KERNEL_MIN_VALUE);
-            }
-            else if (value <= rightBorder)
-            {
-                value = 1.0f;
-            }
-            else
-            {
-                // Scale to [1, SimulationRules::KERNEL_MAX_VALUE]
-                value = 1.0f + (value - rightBorder) / (1.0f - rightBorder) * (SimulationRules::KERNEL_MAX_VALUE - 1.0f);
-            }
+    auto& currentTexture = useTextureA ? textureA : textureB;
+    currentTexture.setData(cells.data());
+    cellsVersion++;
 
-            kernel[i] = value;
-        }
-    }
-    else if (kernelRandomizationType == KernelGenerationType::RandomOnlyPositives)
+    // A pending switch away from the GPU takes these cells instead of the ones being read back
+    if (readbackFence)
     {
-        for (int i = 0; i < kernel.size(); ++i)
-        {
-            float value = Random::Float(1.0f, (float)SimulationRules::KERNEL_MAX_VALUE);
-            kernel[i] = value;
-        }
+        glDeleteSync(readbackFence);
+        readbackFence = nullptr;
+        activeEngine = pendingEngine;
+        secondsPerGeneration = 0.0;
     }
-    else if (kernelRandomizationType == KernelGenerationType::RandomOnlyZerosAndOnes)
-    {
-        for (int i = 0; i < kernel.size(); ++i)
-        {
-            float value = static_cast<float>(Random::Int(0, 1));
-            kernel[i] = value;
-        }
-	}
-    else if (kernelRandomizationType == KernelGenerationType::VonNeumann)
-    {
-        int diameter = neighborSearchRange * 2 + 1;
-        int center = neighborSearchRange;
-        for (int x = 0; x < diameter; ++x)
-        {
-            for (int y = 0; y < diameter; ++y)
-            {
-                int index = x * diameter + y;
-                if (abs(x - center) + abs(y - center) <= neighborSearchRange)
-                {
-                    kernel[index] = 1.0f;
-                }
-                else
-                {
-                    kernel[index] = 0.0f;
-                }
-            }
-        }
-	}
-    else if (kernelRandomizationType == KernelGenerationType::FilledCircle)
-    {
-        int diameter = neighborSearchRange * 2 + 1;
-        int center = neighborSearchRange;
-        float radius = neighborSearchRange;
-        float radiusSquared = radius * radius;
-        for (int x = 0; x < diameter; ++x)
-        {
-            for (int y = 0; y < diameter; ++y)
-            {
-                int index = x * diameter + y;
-                float dx = static_cast<float>(x - center);
-                float dy = static_cast<float>(y - center);
-                float distanceSquared = dx * dx + dy * dy;
-                if (distanceSquared <= radiusSquared)
-                {
-                    kernel[index] = neighborSearchRange - sqrtf(distanceSquared);
-                }
-                else
-                {
-                    kernel[index] = 0.0f;
-                }
-            }
-		}
-	}
-    else if (kernelRandomizationType == KernelGenerationType::FilledCircleWithNegatives)
-    {
-        int diameter = neighborSearchRange * 2 + 1;
-        int center = neighborSearchRange;
-        float radius = neighborSearchRange;
-        float radiusSquared = radius * radius;
-        for (int x = 0; x < diameter; ++x)
-        {
-            for (int y = 0; y < diameter; ++y)
-            {
-                int index = x * diameter + y;
-                float dx = static_cast<float>(x - center);
-                float dy = static_cast<float>(y - center);
-                float distanceSquared = dx * dx + dy * dy;
-                if (distanceSquared <= radiusSquared)
-                {
-                    kernel[index] = neighborSearchRange - sqrtf(distanceSquared);
-                }
-                else
-                {
-                    kernel[index] = neighborSearchRange - sqrtf(distanceSquared);
-                }
-            }
-        }
-	}
-    else if (kernelRandomizationType == KernelGenerationType::Checkerboard)
-    {
-        int diameter = neighborSearchRange * 2 + 1;
-        for (int x = 0; x < diameter; ++x)
-        {
-            for (int y = 0; y < diameter; ++y)
-            {
-                int index = x * diameter + y;
-                if ((x + y) % 2 == 0)
-                {
-                    kernel[index] = 1.0f;
-                }
-                else
-                {
-                    kernel[index] = 0.0f;
-                }
-            }
-        }
-	}
-    else if (kernelRandomizationType == KernelGenerationType::CheckerboardWithNegatives)
+
+    if (activeEngine != EngineType::GpuCompute)
     {
-        int diameter = neighborSearchRange * 2 + 1;
-        for (int x = 0; x < diameter; ++x)
-        {
-            for (int y = 0; y < diameter; ++y)
-            {
-                int index = x * diameter + y;
-                if ((x + y) % 2 == 0)
-                {
-                    kernel[index] = 1.0f;
-                }
-                else
-                {
-                    kernel[index] = -1.0f;
-                }
-            }
-        }
-        }
+        cpuWorld.cells = cells;
+        getCpuEngine(activeEngine)->invalidate();
+    }
 }
 
-void SimulationVisuals::submitToShader(Shader& shader) const
+void Simulation::restore(const std::vector<uint8_t>& cells, uint64_t generation)
 {
-    shader.use();
-    shader.setVec3("aliveCellColor", aliveColor[0], aliveColor[1], aliveColor[2]);
-    shader.setVec3("deadCellColor", deadColor[0], deadColor[1], deadColor[2]);
+    setCells(cells);
+    this->generation = generation;
 }
 
-Simulation::Simulation(int gridW, int gridH, Texture2D& texA, Texture2D& texB)
-    : gridW(gridW), gridH(gridH), textureA(texA), textureB(texB), gen(rd()), dis(0, 1)
+std::vector<uint8_t> Simulation::getCells() const
 {
-    std::vector<Shader::ShaderSource> sources = {
-        { GL_COMPUTE_SHADER, "Shaders/automata.comp" }
-    };
-    computeShader = std::make_unique<Shader>(sources);
-    computeShader->use();
-    computeShader->setInt("gridWidth", gridW);
-    computeShader->setInt("gridHeight", gridH);
-
-    groupsX = ceilf((float)gridW / (float)WORK_GROUP_W);
-    groupsY = ceilf((float)gridH / (float)WORK_GROUP_H);
+    if (activeEngine != EngineType::GpuCompute)
+    {
+        return cpuWorld.cells;
+    }
 
-	glGenBuffers(1, &kernelSSBO);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, kernelSSBO);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, 441 * sizeof(float), nullptr, GL_DYNAMIC_DRAW); // 441 is number of cells with kernel radius 10
-	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, rules.kernel.size() * sizeof(float), rules.kernel.data());
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, kernelSSBO); // binding = 2
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    // Synchronous readback, meant for tools and one-off transfers rather than per-frame use
+    const Texture2D& currentTexture = getCurrentTexture();
+    std::vector<uint8_t> cells((size_t)gridW * gridH);
 
-    randomize();
-    submitRulesToShader();
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTextureImage(currentTexture.getID(), 0, currentTexture.getFormat(), currentTexture.getType(), (GLsizei)cells.size(), cells.data());
+    return cells;
 }
 
-void Simulation::randomize()
+int Simulation::update(double deltaTime)
 {
-    auto& currentTexture = useTextureA ? textureA : textureB;
-    std::vector<uint8_t> data(gridW * gridH);
-    for (int i = 0; i < gridW * gridH; ++i)
+    computeTimer.beginFrame();
+    updateEngine(deltaTime);
+
+    // Stepping now would make the cells being read back stale
+    if (readbackFence && !finishEngineSwitch())
     {
-        data[i] = static_cast<uint8_t>(dis(gen));
+        measureUpdatesRate(deltaTime, 0);
+        return 0;
+    }
+
+    if (isAdvancingGenerations)
+    {
+        int performed = advance();
+        measureUpdatesRate(deltaTime, performed);
+        return performed;
     }
-    currentTexture.setData(data.data());
-}
 
-int Simulation::update(double deltaTime)
-{
     // Pause
     if (!isRunning)
     {
         simulationUpdateCounter = 0.0;
+        isFrameBudgetLimited = false;
+        achievedUpdatesRate = 0.0;
         return 0;
     }
 
-    // Determine updates to perform
-    simulationUpdateCounter += deltaTime;
+    // Determine updates to perform, the ones that do not fit in the frame budget are carried to the next frames
+    simulationUpdateCounter = std::min(simulationUpdateCounter + deltaTime, MAX_BACKLOG_SECONDS);
     int updatesToPerform = static_cast<int>(simulationUpdateCounter * simulationUpdatesRate);
     if (updatesToPerform <= 0)
     {
+        measureUpdatesRate(deltaTime, 0);
         return 0;
     }
 
+    // The GPU engine is measured by its timer, the CPU engines block until the generation is done
+    if (activeEngine == EngineType::GpuCompute && computeTimer.getLastMilliseconds() > 0.0)
+    {
+        secondsPerGeneration = computeTimer.getLastMilliseconds() / 1000.0;
+    }
+    int maxUpdates = updatesToPerform;
+    if (secondsPerGeneration > 0.0)
+    {
+        maxUpdates = std::max(static_cast<int>(frameBudgetSeconds / secondsPerGeneration), 1);
+    }
+    isFrameBudgetLimited = updatesToPerform > maxUpdates;
+    updatesToPerform = std::min(updatesToPerform, maxUpdates);
+
     simulationUpdateCounter -= (double)updatesToPerform / (double)simulationUpdatesRate;
 
+    auto start = std::chrono::steady_clock::now();
+    step(updatesToPerform);
+    if (activeEngine != EngineType::GpuCompute)
+    {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / updatesToPerform;
+        secondsPerGeneration = secondsPerGeneration > 0.0 ? secondsPerGeneration * 0.75 + seconds * 0.25 : seconds;
+    }
+
+    measureUpdatesRate(deltaTime, updatesToPerform);
+    return updatesToPerform;
+}
+
+void Simulation::measureUpdatesRate(double deltaTime, int updates)
+{
+    updatesRateSeconds += deltaTime;
+    updatesRateCount += updates;
+    if (updatesRateSeconds >= UPDATES_RATE_WINDOW_SECONDS)
+    {
+        achievedUpdatesRate = updatesRateCount / updatesRateSeconds;
+        updatesRateSeconds = 0.0;
+        updatesRateCount = 0;
+    }
+}
+
+void Simulation::step(int generations)
+{
+    if (activeEngine != EngineType::GpuCompute)
+    {
+        CpuEngine* engine = getCpuEngine(activeEngine);
+        for (int i = 0; i < generations; i++)
+        {
+            engine->step(cpuWorld);
+            generation++;
+        }
+
+        // Only the newest generation is shown
+        if (generations > 0)
+        {
+            auto& currentTexture = useTextureA ? textureA : textureB;
+            currentTexture.setData(cpuWorld.cells.data());
+        }
+        return;
+    }
+
     // Use compute shader for calculating next world state
     computeShader->use();
+    rulesBuffers.bind();
 
     GLuint aID = textureA.getID();
     GLuint bID = textureB.getID();
 
-    for (int i = 0; i < updatesToPerform; i++)
+    for (int i = 0; i < generations; i++)
     {
 		GLuint currentID = useTextureA ? aID : bID;
 		GLuint nextID = useTextureA ? bID : aID;
@@ -295,22 +218,104 @@ int Simulation::update(double deltaTime)
         glBindImageTexture(1, nextID, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8UI);
 
         // Run compute shader
+        bool isTimed = i < MAX_TIMED_GENERATIONS;
+        if (isTimed)
+        {
+            computeTimer.begin();
+        }
         glDispatchCompute(groupsX, groupsY, 1);
+        if (isTimed)
+        {
+            computeTimer.end();
+        }
         glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
         // Switch textures
         useTextureA = !useTextureA;
+        generation++;
     }
-    return updatesToPerform;
 }
 
 void Simulation::submitRulesToShader()
 {
-	rules.submitToShader(*computeShader);
+    rulesBuffers.submit(rules, *computeShader);
+}
+
+void Simulation::advanceGenerations(uint64_t count)
+{
+    isAdvancingGenerations = count > 0;
+    advanceStartGeneration = generation;
+    advanceTargetGeneration = generation + count;
+    advanceSecondsPerGeneration = 0.0;
+    advanceBatch = 1;
+
+    // Without a texture upload per frame the CPU engines get cheaper, so the choice is made again
+    reselectEngine();
+}
+
+void Simulation::cancelAdvance()
+{
+    isAdvancingGenerations = false;
+    simulationUpdateCounter = 0.0;
+}
+
+bool Simulation::isAdvancing() const
+{
+    return isAdvancingGenerations;
+}
 
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, kernelSSBO);
-    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, rules.kernel.size() * sizeof(float), rules.kernel.data());
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+double Simulation::getAdvanceProgress() const
+{
+    if (advanceTargetGeneration <= advanceStartGeneration)
+    {
+        return 1.0;
+    }
+    return (double)(generation - advanceStartGeneration) / (double)(advanceTargetGeneration - advanceStartGeneration);
+}
+
+int Simulation::advance()
+{
+    // Batches are sized from the measured time per generation to fill the frame budget
+    int performed = 0;
+    if (activeEngine == EngineType::GpuCompute)
+    {
+        // One batch per update, timed by the GPU timer; the caller paces the queued work with fences
+        if (computeTimer.getLastMilliseconds() > 0.0)
+        {
+            advanceSecondsPerGeneration = computeTimer.getLastMilliseconds() / 1000.0;
+            advanceBatch = (int)std::clamp(frameBudgetSeconds / advanceSecondsPerGeneration, 1.0, (double)MAX_ADVANCE_BATCH);
+        }
+        performed = (int)std::min<uint64_t>(advanceBatch, advanceTargetGeneration - generation);
+        step(performed);
+    }
+    else
+    {
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0.0;
+        while (generation < advanceTargetGeneration && elapsed < frameBudgetSeconds)
+        {
+            if (advanceSecondsPerGeneration > 0.0)
+            {
+                double batch = (frameBudgetSeconds - elapsed) / advanceSecondsPerGeneration;
+                advanceBatch = (int)std::clamp(batch, 1.0, (double)MAX_ADVANCE_BATCH);
+            }
+            int batch = (int)std::min<uint64_t>(advanceBatch, advanceTargetGeneration - generation);
+
+            auto batchStart = std::chrono::steady_clock::now();
+            step(batch);
+            auto batchEnd = std::chrono::steady_clock::now();
+
+            advanceSecondsPerGeneration = std::chrono::duration<double>(batchEnd - batchStart).count() / batch;
+            elapsed = std::chrono::duration<double>(batchEnd - start).count();
+            performed += batch;
+        }
+    }
+
+    if (generation >= advanceTargetGeneration)
+    {
+        cancelAdvance();
+    }
+    return performed;
 }
 
 void Simulation::submitVisualsToShader(Shader& shader)
@@ -322,3 +327,195 @@ void Simulation::resetUpdatesCounter()
 {
     simulationUpdateCounter = 0.0;
 }
+
+void Simulation::reselectEngine()
+{
+    secondsSinceEngineSelection = ENGINE_RESELECTION_SECONDS;
+}
+
+void Simulation::releaseThreadResources()
+{
+    computeTimer.release();
+    if (readbackFence)
+    {
+        glDeleteSync(readbackFence);
+        readbackFence = nullptr;
+    }
+    if (readbackBuffer)
+    {
+        glDeleteBuffers(1, &readbackBuffer);
+        readbackBuffer = 0;
+    }
+}
+
+const Texture2D& Simulation::getCurrentTexture() const
+{
+    return useTextureA ? textureA : textureB;
+}
+
+uint64_t Simulation::getGeneration() const
+{
+    return generation;
+}
+
+uint64_t Simulation::getCellsVersion() const
+{
+    return cellsVersion;
+}
+
+EngineType Simulation::getActiveEngine() const
+{
+    return activeEngine;
+}
+
+const std::string& Simulation::getEngineSelectionReason() const
+{
+    return engineSelectionReason;
+}
+
+double Simulation::getAchievedUpdatesRate() const
+{
+    return achievedUpdatesRate;
+}
+
+bool Simulation::isLimitedByFrameBudget() const
+{
+    return isFrameBudgetLimited;
+}
+
+void Simulation::setObservedActivity(double activity)
+{
+    observedActivity = activity;
+}
+
+CpuEngine* Simulation::getCpuEngine(EngineType type) const
+{
+    for (const auto& engine : cpuEngines)
+    {
+        if (engine->getType() == type)
+        {
+            return engine.get();
+        }
+    }
+    return nullptr;
+}
+
+void Simulation::updateEngine(double deltaTime)
+{
+    // Re-evaluate when the rules change, and now and then for the observed activity and update rate
+    uint64_t rulesHash = rules.getHash();
+    bool haveRulesChanged = rulesHash != engineRulesHash;
+    if (isRunning || isAdvancingGenerations)
+    {
+        secondsSinceEngineSelection += deltaTime;
+    }
+    if (!haveRulesChanged && secondsSinceEngineSelection < ENGINE_RESELECTION_SECONDS)
+    {
+        return;
+    }
+    engineRulesHash = rulesHash;
+    secondsSinceEngineSelection = 0.0;
+
+    EngineType type = EngineType::GpuCompute;
+    if (isEngineAutomatic)
+    {
+        double generationsPerUpload = isAdvancingGenerations ? (double)advanceBatch : std::max(simulationUpdatesRate / 60.0, 1.0);
+        EngineSelection selection = costModel.select(rules, cpuEngines, gridW, gridH, observedActivity, generationsPerUpload);
+        type = selection.type;
+        engineSelectionReason = selection.reason;
+    }
+    else if (manualEngine == EngineType::GpuCompute || getCpuEngine(manualEngine)->supports(rules))
+    {
+        type = manualEngine;
+        engineSelectionReason = "selected manually";
+    }
+    else
+    {
+        engineSelectionReason = std::string(ENGINE_TYPE_NAMES[static_cast<int>(manualEngine)]) + " does not support these rules";
+    }
+
+    if (type != EngineType::GpuCompute)
+    {
+        CpuEngine* engine = getCpuEngine(type);
+        if (haveRulesChanged || type != activeEngine)
+        {
+            engine->setRules(rules);
+        }
+    }
+    switchEngine(type);
+}
+
+void Simulation::switchEngine(EngineType type)
+{
+    if (readbackFence)
+    {
+        if (type != EngineType::GpuCompute)
+        {
+            pendingEngine = type;
+            return;
+        }
+        glDeleteSync(readbackFence);
+        readbackFence = nullptr;
+    }
+    if (type == activeEngine)
+    {
+        return;
+    }
+
+    // The CPU side gets its copy once the readback completed, a synchronous one would stall until the GPU is done
+    if (activeEngine == EngineType::GpuCompute)
+    {
+        pendingEngine = type;
+        startReadback();
+        return;
+    }
+
+    // The texture always holds the newest generation, so switching to the GPU needs no copy
+    if (type != EngineType::GpuCompute)
+    {
+        getCpuEngine(type)->invalidate();
+    }
+    activeEngine = type;
+    secondsPerGeneration = 0.0;
+}
+
+void Simulation::startReadback()
+{
+    GLsizeiptr size = (GLsizeiptr)gridW * gridH;
+    if (!readbackBuffer)
+    {
+        glGenBuffers(1, &readbackBuffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    }
+
+    // With a pack buffer bound the texture is copied into it on the GPU and the call returns at once
+    const Texture2D& currentTexture = getCurrentTexture();
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTextureImage(currentTexture.getID(), 0, currentTexture.getFormat(), currentTexture.getType(), (GLsizei)size, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // Flushed, so the fence is sure to signal while it is only polled
+    readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+}
+
+bool Simulation::finishEngineSwitch()
+{
+    GLint status = GL_UNSIGNALED;
+    glGetSynciv(readbackFence, GL_SYNC_STATUS, 1, nullptr, &status);
+    if (status != GL_SIGNALED)
+    {
+        return false;
+    }
+    glDeleteSync(readbackFence);
+    readbackFence = nullptr;
+
+    glGetNamedBufferSubData(readbackBuffer, 0, (GLsizeiptr)cpuWorld.cells.size(), cpuWorld.cells.data());
+    getCpuEngine(pendingEngine)->invalidate();
+    activeEngine = pendingEngine;
+    secondsPerGeneration = 0.0;
+    return true;
+}
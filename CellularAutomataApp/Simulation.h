@@ -1,58 +1,17 @@
 #pragma once
 #include "Texture2D.h"
+#include "SimulationRules.h"
 #include "Shader.h"
+#include "GpuProfiler.h"
+#include "CpuEngine.h"
+#include "EngineCostModel.h"
+#include "RulesBuffers.h"
+#include <atomic>
 #include <random>
+#include <cstdint>
 #include <vector>
 #include <memory>
 
-enum KernelGenerationType : int
-{
-    RandomAllValues = 0,
-    RandomOnlyPositives,
-    RandomOnlyZerosAndOnes,
-    VonNeumann,
-    FilledCircle,
-    FilledCircleWithNegatives,
-    Checkerboard,
-    CheckerboardWithNegatives,
-	COUNT_ // Not an actual type, just a count of types
-};
-
-static char* KERNEL_GENERATION_TYPE_NAMES[] =
-{
-    (char*)"Random - All values",
-    (char*)"Random - Only positives",
-    (char*)"Random - Only 0 and 1",
-	(char*)"Von Neumann",
-	(char*)"Filled Circle",
-	(char*)"Filled Circle with negatives",
-	(char*)"Checkerboard",
-	(char*)"Checkerboard with negatives"
-};
-
-struct SimulationRules
-{
-	static const int MAX_NEIGHBOR_SEARCH_RANGE = 10;
-    static const int KERNEL_MIN_VALUE = -2;
-	static const int KERNEL_MAX_VALUE = 2;
-
-    int neighborSearchRange = 1;
-    int stableRange[2] = { 2, 3 };
-    int birthRange[2] = { 3, 3 };
-	std::vector<float> kernel;
-
-	int previousNeighborSearchRange = 1;
-
-	KernelGenerationType kernelRandomizationType = KernelGenerationType::RandomAllValues;
-
-    SimulationRules();
-
-    void submitToShader(Shader& shader) const;
-	float getMaxNeighborSum() const;
-    void updateKernelSize();
-	void randomizeKernel();
-};
-
 struct SimulationVisuals
 {
 	float aliveColor[3] = { 1.0f, 1.0f, 1.0f };
@@ -75,20 +34,88 @@ class Simulation
     std::uniform_int_distribution<> dis;
 
     std::unique_ptr<Shader> computeShader;
+    RulesBuffers rulesBuffers;
+    GpuTimer computeTimer;
 
     double simulationUpdateCounter = 0.0;
+    uint64_t generation = 0;
+    uint64_t cellsVersion = 0; // Counts the times the cells were replaced outside step()
+
+    std::vector<std::unique_ptr<CpuEngine>> cpuEngines;
+    CpuWorld cpuWorld;
+    EngineType activeEngine = EngineType::GpuCompute;
+    std::string engineSelectionReason = "default";
+    uint64_t engineRulesHash = 0;
+    double secondsSinceEngineSelection = 0.0;
+    std::atomic<double> observedActivity{ 0.1 }; // Set by readback consumers on the main thread
+
+    // Switching away from the GPU engine waits for an asynchronous readback of the cells, see switchEngine()
+    EngineType pendingEngine = EngineType::GpuCompute;
+    GLuint readbackBuffer = 0;
+    GLsync readbackFence = nullptr;
+
+    // Fast-forward state, see advanceGenerations()
+    bool isAdvancingGenerations = false;
+    uint64_t advanceStartGeneration = 0;
+    uint64_t advanceTargetGeneration = 0;
+    double advanceSecondsPerGeneration = 0.0;
+    int advanceBatch = 1;
+
+    // Frame budget governor, see update()
+    double secondsPerGeneration = 0.0;
+    bool isFrameBudgetLimited = false;
+    double achievedUpdatesRate = 0.0;
+    double updatesRateSeconds = 0.0;
+    int updatesRateCount = 0;
+
+    CpuEngine* getCpuEngine(EngineType type) const;
+    void updateEngine(double deltaTime);
+    void switchEngine(EngineType type);
+    void startReadback();
+    bool finishEngineSwitch(); // False while the readback is still in flight
+    int advance();
+    void measureUpdatesRate(double deltaTime, int updates);
 public:
     SimulationRules rules;
 	SimulationVisuals visuals;
     bool useTextureA = true;
-    GLuint kernelSSBO;
     bool isRunning = true;
     int simulationUpdatesRate = 60;
+    double frameBudgetSeconds = 0.008; // Time one update() may spend stepping, measured per generation
+
+    EngineCostModel costModel;
+    bool isEngineAutomatic = true;
+    EngineType manualEngine = EngineType::GpuCompute;
 
     Simulation(int gridW, int gridH, Texture2D& texA, Texture2D& texB);
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
     void randomize();
     int update(double deltaTime);
+    void step(int generations);
+    void setCells(const std::vector<uint8_t>& cells);
+    void restore(const std::vector<uint8_t>& cells, uint64_t generation); // Cells of an earlier generation, e.g. from RewindHistory
+    std::vector<uint8_t> getCells() const;
 	void submitRulesToShader();
 	void submitVisualsToShader(Shader& shader);
     void resetUpdatesCounter();
+    void releaseThreadResources(); // Objects of the context that stepped the simulation, e.g. on SimulationThread
+    void reselectEngine(); // On the next update(), e.g. after isEngineAutomatic or manualEngine changed
+
+    // Steps count generations as fast as the active engine allows, spread over the next update() calls
+    // so the window stays responsive; only the last generation of every frame is shown
+    void advanceGenerations(uint64_t count);
+    void cancelAdvance();
+    bool isAdvancing() const;
+    double getAdvanceProgress() const;
+
+    const Texture2D& getCurrentTexture() const;
+    uint64_t getGeneration() const;
+    uint64_t getCellsVersion() const;
+
+    EngineType getActiveEngine() const;
+    const std::string& getEngineSelectionReason() const;
+    double getAchievedUpdatesRate() const;
+    bool isLimitedByFrameBudget() const; // The last update() performed fewer generations than the rate asks for
+    void setObservedActivity(double activity);
 };
\ No newline at end of file
@@ -0,0 +1,356 @@
+#include "SimulationRules.h"
+#include <glad/glad.h>
+#include <math.h>
+#include <algorithm>
+#include "Random.h"
+
+SimulationRules::SimulationRules()
+{
+    int maxDiameter = MAX_NEIGHBOR_SEARCH_RANGE * 2 + 1;
+    int maxTotalCells = maxDiameter * maxDiameter;
+    kernel.reserve(maxTotalCells);
+
+    int diameter = neighborSearchRange * 2 + 1;
+    int totalCells = diameter * diameter;
+	kernel.resize(totalCells, 1.0f);
+
+	kernel[neighborSearchRange + neighborSearchRange * diameter] = 0.0f; // Center cell should not contribute to the sum
+}
+
+SimulationRules SimulationRules::createTestRules(int neighborSearchRange, KernelGenerationType type)
+{
+    SimulationRules rules;
+    rules.neighborSearchRange = neighborSearchRange;
+    rules.updateKernelSize();
+    rules.kernelRandomizationType = type;
+    rules.randomizeKernel();
+
+    float maxNeighborSum = rules.getMaxNeighborSum();
+    rules.stableRange[0] = (int)roundf(maxNeighborSum * 0.25f);
+    rules.stableRange[1] = (int)roundf(maxNeighborSum * 0.45f);
+    rules.birthRange[0] = (int)roundf(maxNeighborSum * 0.30f);
+    rules.birthRange[1] = (int)roundf(maxNeighborSum * 0.40f);
+    return rules;
+}
+
+void SimulationRules::submitToShader(Shader& shader) const
+{
+    shader.use();
+    shader.setInt("neighborSearchRange", neighborSearchRange);
+    shader.setUvec2("stableRange", stableRange[0], stableRange[1]);
+    shader.setUvec2("birthRange", birthRange[0], birthRange[1]);
+}
+
+float SimulationRules::getMaxNeighborSum() const
+{
+	float maxSum = 0.0f;
+
+	int diameter = neighborSearchRange * 2 + 1;
+
+    for (int r = 0; r < diameter; ++r)
+    {
+        for (int c = 0; c < diameter; ++c)
+        {
+            int index = r * diameter + c;
+			float value = kernel[index];
+            if (value > 0.0f)
+            {
+				maxSum += value;
+            }
+        }
+	}
+
+    return maxSum;
+}
+
+uint64_t SimulationRules::getHash() const
+{
+    // FNV-1a over everything that affects the next generation
+    uint64_t hash = 14695981039346656037ull;
+    auto addBytes = [&hash](const void* data, size_t size)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+        };
+
+    addBytes(&neighborSearchRange, sizeof(neighborSearchRange));
+    addBytes(stableRange, sizeof(stableRange));
+    addBytes(birthRange, sizeof(birthRange));
+    addBytes(kernel.data(), kernel.size() * sizeof(float));
+    return hash;
+}
+
+// Scaled threshold of an unsigned range bound, clamped far above any int16 sum
+static int scaleRangeBound(int value, int denominator)
+{
+    int64_t scaled = (int64_t)(unsigned int)value * denominator;
+    return (int)std::min<int64_t>(scaled, INT32_MAX);
+}
+
+FixedPointRules SimulationRules::getFixedPointRules() const
+{
+    FixedPointRules fixedPoint;
+    for (int denominator = 1; denominator <= FixedPointRules::MAX_DENOMINATOR; denominator *= 2)
+    {
+        // Multiplying by a power of two is exact, so a whole result means the weight is exactly k / denominator
+        bool isExact = true;
+        int64_t absoluteSum = 0;
+        for (float value : kernel)
+        {
+            float scaled = value * denominator;
+            if (scaled != floorf(scaled) || fabsf(scaled) > INT16_MAX)
+            {
+                isExact = false;
+                break;
+            }
+            absoluteSum += (int64_t)fabsf(scaled);
+        }
+        if (!isExact || absoluteSum > INT16_MAX)
+        {
+            continue;
+        }
+
+        fixedPoint.denominator = denominator;
+        fixedPoint.weights.resize(kernel.size());
+        for (size_t i = 0; i < kernel.size(); ++i)
+        {
+            fixedPoint.weights[i] = (int16_t)(kernel[i] * denominator);
+        }
+        fixedPoint.stableRange[0] = scaleRangeBound(stableRange[0], denominator);
+        fixedPoint.stableRange[1] = scaleRangeBound(stableRange[1], denominator);
+        fixedPoint.birthRange[0] = scaleRangeBound(birthRange[0], denominator);
+        fixedPoint.birthRange[1] = scaleRangeBound(birthRange[1], denominator);
+
+        // Same decisions as the shader: birth first, then stable, then dead
+        TransitionTable& transitions = fixedPoint.transitions;
+        transitions.minSum = 0;
+        for (int16_t weight : fixedPoint.weights)
+        {
+            transitions.minSum += std::min<int>(weight, 0);
+        }
+        transitions.sumsCount = (int)absoluteSum + 1;
+        transitions.nextStates.resize((size_t)TransitionTable::STATES_COUNT * transitions.sumsCount);
+        for (int state = 0; state < TransitionTable::STATES_COUNT; ++state)
+        {
+            for (int i = 0; i < transitions.sumsCount; ++i)
+            {
+                int sum = transitions.minSum + i;
+                uint8_t nextState = 0;
+                if (sum >= fixedPoint.birthRange[0] && sum <= fixedPoint.birthRange[1])
+                {
+                    nextState = 1;
+                }
+                else if (sum >= fixedPoint.stableRange[0] && sum <= fixedPoint.stableRange[1])
+                {
+                    nextState = (uint8_t)state;
+                }
+                transitions.nextStates[(size_t)state * transitions.sumsCount + i] = nextState;
+            }
+        }
+        break;
+    }
+    return fixedPoint;
+}
+
+bool SimulationRules::isRadiallySymmetric() const
+{
+    int diameter = neighborSearchRange * 2 + 1;
+    int maxDistanceSquared = 2 * neighborSearchRange * neighborSearchRange;
+    if ((int)kernel.size() < diameter * diameter)
+    {
+        return false;
+    }
+
+    // Weight of the first tap seen at every squared distance
+    std::vector<float> weights(maxDistanceSquared + 1, 0.0f);
+    std::vector<bool> isSeen(maxDistanceSquared + 1, false);
+    for (int y = 0; y < diameter; ++y)
+    {
+        for (int x = 0; x < diameter; ++x)
+        {
+            int dx = x - neighborSearchRange;
+            int dy = y - neighborSearchRange;
+            int distanceSquared = dx * dx + dy * dy;
+            float value = kernel[y * diameter + x];
+            if (!isSeen[distanceSquared])
+            {
+                isSeen[distanceSquared] = true;
+                weights[distanceSquared] = value;
+            }
+            else if (weights[distanceSquared] != value)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void SimulationRules::updateKernelSize()
+{
+    if (neighborSearchRange != previousNeighborSearchRange)
+    {
+        int diameter = neighborSearchRange * 2 + 1;
+        int totalCells = diameter * diameter;
+		kernel.resize(totalCells, 1.0f);
+    }
+	previousNeighborSearchRange = neighborSearchRange;
+}
+
+void SimulationRules::randomizeKernel()
+{
+    if (kernelRandomizationType == KernelGenerationType::RandomAllValues)
+    {
+        const float leftBorder = 0.2f;
+        const float rightBorder = 0.8f;
+
+        for (int i = 0; i < kernel.size(); ++i)
+        {
+            float value = Random::Float(0.0f, 1.0f);
+
+            if (value < leftBorder)
+            {
+                // Scale to [SimulationRules::KERNEL_MIN_VALUE, 1]
+                value = SimulationRules::KERNEL_MIN_VALUE + value / leftBorder * (1.0f - SimulationRules::KERNEL_MIN_VALUE);
+            }
+            else if (value <= rightBorder)
+            {
+                value = 1.0f;
+            }
+            else
+            {
+                // Scale to [1, SimulationRules::KERNEL_MAX_VALUE]
+                value = 1.0f + (value - rightBorder) / (1.0f - rightBorder) * (SimulationRules::KERNEL_MAX_VALUE - 1.0f);
+            }
+
+            kernel[i] = value;
+        }
+    }
+    else if (kernelRandomizationType == KernelGenerationType::RandomOnlyPositives)
+    {
+        for (int i = 0; i < kernel.size(); ++i)
+        {
+            float value = Random::Float(1.0f, (float)SimulationRules::KERNEL_MAX_VALUE);
+            kernel[i] = value;
+        }
+    }
+    else if (kernelRandomizationType == KernelGenerationType::RandomOnlyZerosAndOnes)
+    {
+        for (int i = 0; i < kernel.size(); ++i)
+        {
+            float value = static_cast<float>(Random::Int(0, 1));
+            kernel[i] = value;
+        }
+	}
+    else if (kernelRandomizationType == KernelGenerationType::VonNeumann)
+    {
+        int diameter = neighborSearchRange * 2 + 1;
+        int center = neighborSearchRange;
+        for (int x = 0; x < diameter; ++x)
+        {
+            for (int y = 0; y < diameter; ++y)
+            {
+                int index = x * diameter + y;
+                if (abs(x - center) + abs(y - center) <= neighborSearchRange)
+                {
+                    kernel[index] = 1.0f;
+                }
+                else
+                {
+                    kernel[index] = 0.0f;
+                }
+            }
+        }
+	}
+    else if (kernelRandomizationType == KernelGenerationType::FilledCircle)
+    {
+        int diameter = neighborSearchRange * 2 + 1;
+        int center = neighborSearchRange;
+        float radius = neighborSearchRange;
+        float radiusSquared = radius * radius;
+        for (int x = 0; x < diameter; ++x)
+        {
+            for (int y = 0; y < diameter; ++y)
+            {
+                int index = x * diameter + y;
+                float dx = static_cast<float>(x - center);
+                float dy = static_cast<float>(y - center);
+                float distanceSquared = dx * dx + dy * dy;
+                if (distanceSquared <= radiusSquared)
+                {
+                    kernel[index] = neighborSearchRange - sqrtf(distanceSquared);
+                }
+                else
+                {
+                    kernel[index] = 0.0f;
+                }
+            }
+		}
+	}
+    else if (kernelRandomizationType == KernelGenerationType::FilledCircleWithNegatives)
+    {
+        int diameter = neighborSearchRange * 2 + 1;
+        int center = neighborSearchRange;
+        float radius = neighborSearchRange;
+        float radiusSquared = radius * radius;
+        for (int x = 0; x < diameter; ++x)
+        {
+            for (int y = 0; y < diameter; ++y)
+            {
+                int index = x * diameter + y;
+                float dx = static_cast<float>(x - center);
+                float dy = static_cast<float>(y - center);
+                float distanceSquared = dx * dx + dy * dy;
+                if (distanceSquared <= radiusSquared)
+                {
+                    kernel[index] = neighborSearchRange - sqrtf(distanceSquared);
+                }
+                else
+                {
+                    kernel[index] = neighborSearchRange - sqrtf(distanceSquared);
+                }
+            }
+        }
+	}
+    else if (kernelRandomizationType == KernelGenerationType::Checkerboard)
+    {
+        int diameter = neighborSearchRange * 2 + 1;
+        for (int x = 0; x < diameter; ++x)
+        {
+            for (int y = 0; y < diameter; ++y)
+            {
+                int index = x * diameter + y;
+                if ((x + y) % 2 == 0)
+                {
+                    kernel[index] = 1.0f;
+                }
+                else
+                {
+                    kernel[index] = 0.0f;
+                }
+            }
+        }
+	}
+    else if (kernelRandomizationType == KernelGenerationType::CheckerboardWithNegatives)
+    {
+        int diameter = neighborSearchRange * 2 + 1;
+        for (int x = 0; x < diameter; ++x)
+        {
+            for (int y = 0; y < diameter; ++y)
+            {
+                int index = x * diameter + y;
+                if ((x + y) % 2 == 0)
+                {
+                    kernel[index] = 1.0f;
+                }
+                else
+                {
+                    kernel[index] = -1.0f;
+                }
+            }
+        }
+        }
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "Shader.h"
+#include <vector>
+#include <cstdint>
+
+enum KernelGenerationType : int
+{
+    RandomAllValues = 0,
+    RandomOnlyPositives,
+    RandomOnlyZerosAndOnes,
+    VonNeumann,
+    FilledCircle,
+    FilledCircleWithNegatives,
+    Checkerboard,
+    CheckerboardWithNegatives,
+	COUNT_ // Not an actual type, just a count of types
+};
+
+static char* KERNEL_GENERATION_TYPE_NAMES[] =
+{
+    (char*)"Random - All values",
+    (char*)"Random - Only positives",
+    (char*)"Random - Only 0 and 1",
+	(char*)"Von Neumann",
+	(char*)"Filled Circle",
+	(char*)"Filled Circle with negatives",
+	(char*)"Checkerboard",
+	(char*)"Checkerboard with negatives"
+};
+
+// Next state for every (state, fixed-point sum) pair, so stepping needs no range comparisons.
+// Any set of sums can map to any state, not only the stable and birth intervals.
+struct TransitionTable
+{
+    static const int STATES_COUNT = 2;
+
+    int minSum = 0;    // Sum of the negative weights
+    int sumsCount = 0; // Sum of the absolute weights + 1
+    std::vector<uint8_t> nextStates; // [state * sumsCount + sum - minSum]
+
+    uint8_t getNextState(uint8_t state, int sum) const { return nextStates[state * sumsCount + sum - minSum]; }
+};
+
+// Kernel weights as integers over a power of two denominator. Every partial float sum of such a kernel is exact,
+// so comparing the integer sum against the ranges scaled by the denominator gives the same result as the float path.
+struct FixedPointRules
+{
+    static const int MAX_DENOMINATOR = 32;
+
+    int denominator = 0; // 0 when the kernel has no exact form with sums that fit int16
+    std::vector<int16_t> weights;
+    int stableRange[2] = { 0, 0 };
+    int birthRange[2] = { 0, 0 };
+    TransitionTable transitions;
+
+    bool isValid() const { return denominator > 0; }
+};
+
+struct SimulationRules
+{
+	static const int MAX_NEIGHBOR_SEARCH_RANGE = 10;
+    static const int KERNEL_MIN_VALUE = -2;
+	static const int KERNEL_MAX_VALUE = 2;
+
+    int neighborSearchRange = 1;
+    int stableRange[2] = { 2, 3 };
+    int birthRange[2] = { 3, 3 };
+	std::vector<float> kernel;
+
+	int previousNeighborSearchRange = 1;
+
+	KernelGenerationType kernelRandomizationType = KernelGenerationType::RandomAllValues;
+
+    SimulationRules();
+
+    // Rules with a generated kernel and ranges scaled to its maximum sum, used by the tools
+    static SimulationRules createTestRules(int neighborSearchRange, KernelGenerationType type);
+
+    void submitToShader(Shader& shader) const;
+	float getMaxNeighborSum() const;
+    uint64_t getHash() const;
+    FixedPointRules getFixedPointRules() const;
+    bool isRadiallySymmetric() const; // Every weight depends only on the distance from the center
+    void updateKernelSize();
+	void randomizeKernel();
+};
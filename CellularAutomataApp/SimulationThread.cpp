@@ -0,0 +1,292 @@
+#include "SimulationThread.h"
+#include <chrono>
+#include <iostream>
+#include "CpuProfiler.h"
+#include "TraceRecorder.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#endif
+
+const int IDLE_SLEEP_MILLISECONDS = 1;
+const unsigned int TIMER_RESOLUTION_MILLISECONDS = 1;
+
+SimulationThread::SimulationThread(GLFWwindow* sharedWindow, Simulation& simulation, int gridW, int gridH)
+    : simulation(simulation), gridW(gridW), gridH(gridH), sharedWindow(sharedWindow), tripleBuffer(MAX_IN_FLIGHT_UPDATES)
+{
+    settings.rules = simulation.rules;
+    settings.isRunning = simulation.isRunning;
+    settings.updatesRate = simulation.simulationUpdatesRate;
+    settings.frameBudgetSeconds = simulation.frameBudgetSeconds;
+    settings.isEngineAutomatic = simulation.isEngineAutomatic;
+    settings.manualEngine = simulation.manualEngine;
+    rulesHash = settings.rules.getHash();
+
+    frames.resize(tripleBuffer.getSlotsCount());
+    for (Frame& frame : frames)
+    {
+        frame.texture = std::make_unique<Texture2D>(gridW, gridH);
+    }
+    for (int slot = 0; slot < MAX_IN_FLIGHT_UPDATES; ++slot)
+    {
+        freeSlots.push_back(slot);
+    }
+}
+
+SimulationThread::~SimulationThread()
+{
+    stop();
+
+    // Sync objects are shared, the main context can delete what the thread left behind
+    for (Frame& frame : frames)
+    {
+        if (frame.readFence)
+        {
+            glDeleteSync(frame.readFence);
+        }
+    }
+}
+
+bool SimulationThread::start()
+{
+    // Windows can only be created on the main thread, the context is then moved to the simulation thread
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    context = glfwCreateWindow(1, 1, "Simulation", nullptr, sharedWindow);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!context)
+    {
+        std::cerr << "Failed to create the shared OpenGL context for the simulation thread" << std::endl;
+        return false;
+    }
+
+    // Everything the main context created so far must be complete before the other context uses it
+    glFinish();
+
+    isStopping = false;
+    thread = std::thread([this]() { threadLoop(); });
+    return true;
+}
+
+void SimulationThread::stop()
+{
+    isStopping = true;
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+    if (context)
+    {
+        glfwDestroyWindow(context);
+        context = nullptr;
+    }
+}
+
+void SimulationThread::post(CommandQueue::Command command)
+{
+    commands.push(std::move(command));
+}
+
+void SimulationThread::postSettings(const SimulationSettings& newSettings)
+{
+    uint64_t newRulesHash = newSettings.rules.getHash();
+    if (newRulesHash != rulesHash)
+    {
+        rulesHash = newRulesHash;
+        post([rules = newSettings.rules](Simulation& s)
+            {
+                ScopedCpuZone rulesZone(CpuZone::RulesUpload);
+                s.rules = rules;
+                s.submitRulesToShader();
+            });
+    }
+
+    if (newSettings.isRunning != settings.isRunning)
+    {
+        post([isRunning = newSettings.isRunning](Simulation& s) { s.isRunning = isRunning; });
+    }
+    if (newSettings.updatesRate != settings.updatesRate)
+    {
+        post([updatesRate = newSettings.updatesRate](Simulation& s)
+            {
+                s.simulationUpdatesRate = updatesRate;
+                s.resetUpdatesCounter();
+            });
+    }
+    if (newSettings.frameBudgetSeconds != settings.frameBudgetSeconds)
+    {
+        post([frameBudgetSeconds = newSettings.frameBudgetSeconds](Simulation& s) { s.frameBudgetSeconds = frameBudgetSeconds; });
+    }
+    if (newSettings.isEngineAutomatic != settings.isEngineAutomatic || newSettings.manualEngine != settings.manualEngine)
+    {
+        post([isEngineAutomatic = newSettings.isEngineAutomatic, manualEngine = newSettings.manualEngine](Simulation& s)
+            {
+                s.isEngineAutomatic = isEngineAutomatic;
+                s.manualEngine = manualEngine;
+                s.reselectEngine();
+            });
+    }
+
+    settings = newSettings;
+}
+
+const SimulationSettings& SimulationThread::getSettings() const
+{
+    return settings;
+}
+
+int SimulationThread::takeUpdatesCount()
+{
+    return updatesCount.exchange(0);
+}
+
+bool SimulationThread::acquireFrame()
+{
+    if (!tripleBuffer.isNewerPublished())
+    {
+        return false;
+    }
+
+    // The thread waits for this before copying into the texture again
+    if (isFrameAcquired)
+    {
+        Frame& previousFrame = frames[tripleBuffer.getReadIndex()];
+        previousFrame.readFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+    }
+
+    // Published frames are complete, so nothing has to be waited for
+    tripleBuffer.acquire();
+    isFrameAcquired = true;
+    return true;
+}
+
+bool SimulationThread::hasFrame() const
+{
+    return isFrameAcquired;
+}
+
+const Texture2D& SimulationThread::getFrameTexture() const
+{
+    return *frames[tripleBuffer.getReadIndex()].texture;
+}
+
+const SimulationStatus& SimulationThread::getFrameStatus() const
+{
+    return frames[tripleBuffer.getReadIndex()].status;
+}
+
+void SimulationThread::threadLoop()
+{
+    glfwMakeContextCurrent(context);
+    TraceRecorder::setThreadName("Simulation");
+#ifdef _WIN32
+    // Sleeps are rounded up to the timer resolution, about 15 ms by default
+    timeBeginPeriod(TIMER_RESOLUTION_MILLISECONDS);
+#endif
+
+    bool isPublishNeeded = true; // The initial cells
+    auto previousTime = std::chrono::steady_clock::now();
+    while (!isStopping)
+    {
+        publishCompleted();
+        if (freeSlots.empty())
+        {
+            // The oldest fence is polled again right away, waiting on it would stall in the driver
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Commands land between two generations
+        isPublishNeeded = commands.runAll(simulation) > 0 || isPublishNeeded;
+
+        auto currentTime = std::chrono::steady_clock::now();
+        double deltaTime = std::chrono::duration<double>(currentTime - previousTime).count();
+        previousTime = currentTime;
+        int performed = 0;
+        {
+            ScopedCpuZone updateZone(CpuZone::SimulationUpdate);
+            performed = simulation.update(deltaTime);
+        }
+
+        updatesCount += performed;
+        if (performed > 0 || isPublishNeeded)
+        {
+            queueFrame();
+            isPublishNeeded = false;
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_SLEEP_MILLISECONDS));
+        }
+    }
+
+    for (InFlightFrame& inFlightFrame : inFlightFrames)
+    {
+        glDeleteSync(inFlightFrame.fence);
+    }
+    inFlightFrames.clear();
+    simulation.releaseThreadResources();
+    glFinish();
+    glfwMakeContextCurrent(nullptr);
+#ifdef _WIN32
+    timeEndPeriod(TIMER_RESOLUTION_MILLISECONDS);
+#endif
+}
+
+void SimulationThread::publishCompleted()
+{
+    // Fences signal in order, the status query never waits
+    while (!inFlightFrames.empty())
+    {
+        InFlightFrame& oldest = inFlightFrames.front();
+        GLint status = GL_UNSIGNALED;
+        glGetSynciv(oldest.fence, GL_SYNC_STATUS, 1, nullptr, &status);
+        if (status != GL_SIGNALED)
+        {
+            break;
+        }
+
+        glDeleteSync(oldest.fence);
+        freeSlots.push_back(tripleBuffer.publish(oldest.slot));
+        inFlightFrames.pop_front();
+    }
+}
+
+void SimulationThread::queueFrame()
+{
+    int slot = freeSlots.back();
+    freeSlots.pop_back();
+
+    // Waits on the GPU, until the main context is done with the texture
+    Frame& frame = frames[slot];
+    if (frame.readFence)
+    {
+        glWaitSync(frame.readFence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(frame.readFence);
+        frame.readFence = nullptr;
+    }
+
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    const Texture2D& source = simulation.getCurrentTexture();
+    glCopyImageSubData(
+        source.getID(), GL_TEXTURE_2D, 0, 0, 0, 0,
+        frame.texture->getID(), GL_TEXTURE_2D, 0, 0, 0, 0,
+        gridW, gridH, 1
+    );
+
+    SimulationStatus& status = frame.status;
+    status.generation = simulation.getGeneration();
+    status.cellsVersion = simulation.getCellsVersion();
+    status.activeEngine = simulation.getActiveEngine();
+    status.engineSelectionReason = simulation.getEngineSelectionReason();
+    status.achievedUpdatesRate = simulation.getAchievedUpdatesRate();
+    status.isLimitedByFrameBudget = simulation.isLimitedByFrameBudget();
+    status.isAdvancing = simulation.isAdvancing();
+    status.advanceProgress = simulation.getAdvanceProgress();
+
+    // Flushed, so the fence is sure to signal while it is only polled
+    inFlightFrames.push_back({ slot, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+    glFlush();
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CommandQueue.h"
+#include "Simulation.h"
+#include "Texture2D.h"
+#include "TripleBuffer.h"
+
+// Settings the UI edits on its own copy, postSettings() sends the ones that changed
+struct SimulationSettings
+{
+    SimulationRules rules;
+    bool isRunning = true;
+    int updatesRate = 60;
+    double frameBudgetSeconds = 0.008;
+    bool isEngineAutomatic = true;
+    EngineType manualEngine = EngineType::GpuCompute;
+};
+
+// State of the simulation published together with each generation
+struct SimulationStatus
+{
+    uint64_t generation = 0;
+    uint64_t cellsVersion = 0; // Changes when the cells are replaced without stepping, e.g. randomized
+    EngineType activeEngine = EngineType::GpuCompute;
+    std::string engineSelectionReason;
+    double achievedUpdatesRate = 0.0;
+    bool isLimitedByFrameBudget = false;
+    bool isAdvancing = false;
+    double advanceProgress = 0.0;
+};
+
+// SimulationThread class for stepping a Simulation away from the window thread.
+// The thread owns a hidden window whose OpenGL context shares objects with the main one, so the GPU
+// engine dispatches from there; the CPU engines only touch OpenGL for their texture upload.
+// After every update the newest generation is copied into a texture and a fence is placed behind it.
+// Up to MAX_IN_FLIGHT_UPDATES updates are queued on the GPU; a texture is handed to the renderer through
+// a TripleBuffer only once its fence signaled, so drawing it never waits. The thread polls the fences
+// and queues nothing while the queue is full; it then yields and polls the oldest fence again.
+// Once started, the simulation is only touched by the thread: other threads post commands, which run
+// between two updates, and read the SimulationStatus of the frame they acquired.
+class SimulationThread
+{
+public:
+    static const int MAX_IN_FLIGHT_UPDATES = 2; // Matches the double-buffered queries of GpuTimer
+
+    // Needs the main context to be current, creates the shared context
+    SimulationThread(GLFWwindow* sharedWindow, Simulation& simulation, int gridW, int gridH);
+    ~SimulationThread();
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    bool start(); // False when the shared context could not be created
+    void stop();
+
+    void post(CommandQueue::Command command);
+    int takeUpdatesCount(); // Generations stepped since the previous call
+
+    // Posts only the settings that differ from the previous call, the rules are uploaded only when they changed
+    void postSettings(const SimulationSettings& settings);
+    const SimulationSettings& getSettings() const; // The ones posted last, initially those of the simulation
+
+    // Main thread, the newest completed generation becomes the one to draw, false when there was none newer
+    bool acquireFrame();
+    bool hasFrame() const;
+    const Texture2D& getFrameTexture() const;
+    const SimulationStatus& getFrameStatus() const;
+private:
+    struct Frame
+    {
+        std::unique_ptr<Texture2D> texture;
+        SimulationStatus status;
+        GLsync readFence = nullptr; // Behind the last use by the main context, waited on before the next copy
+    };
+
+    struct InFlightFrame
+    {
+        int slot = 0;
+        GLsync fence = nullptr; // Behind the update and the copy into the frame
+    };
+
+    Simulation& simulation;
+    int gridW;
+    int gridH;
+    GLFWwindow* sharedWindow;
+    GLFWwindow* context = nullptr;
+
+    CommandQueue commands;
+    SimulationSettings settings;
+    uint64_t rulesHash = 0;
+
+    TripleBuffer tripleBuffer;
+    std::vector<Frame> frames;
+    bool isFrameAcquired = false;
+
+    // Simulation thread
+    std::vector<int> freeSlots;
+    std::deque<InFlightFrame> inFlightFrames;
+
+    std::atomic<bool> isStopping{ false };
+    std::atomic<int> updatesCount{ 0 };
+    std::thread thread;
+
+    void threadLoop();
+    void publishCompleted();
+    void queueFrame();
+};
@@ -0,0 +1,117 @@
+#include "SlidingWindowCpuEngine.h"
+#include <algorithm>
+#include "ThreadPool.h"
+
+EngineType SlidingWindowCpuEngine::getType() const
+{
+    return EngineType::SlidingWindowCpu;
+}
+
+bool SlidingWindowCpuEngine::supports(const SimulationRules& rules) const
+{
+    // Runs are summed out of shader order, which is only exact for fixed-point kernels
+    return rules.getFixedPointRules().isValid();
+}
+
+void SlidingWindowCpuEngine::setRules(const SimulationRules& rules)
+{
+    neighborSearchRange = rules.neighborSearchRange;
+    fixedPoint = rules.getFixedPointRules();
+
+    int diameter = neighborSearchRange * 2 + 1;
+    runs.clear();
+    for (int ky = 0; ky < diameter; ++ky)
+    {
+        for (int kx = 0; kx < diameter; ++kx)
+        {
+            int16_t weight = fixedPoint.weights[ky * diameter + kx];
+            if (weight == 0)
+            {
+                continue;
+            }
+
+            if (!runs.empty() && runs.back().dy == ky - neighborSearchRange && runs.back().lastX == kx - 1 && runs.back().weight == weight)
+            {
+                runs.back().lastX = kx;
+            }
+            else
+            {
+                WeightRun run;
+                run.dy = ky - neighborSearchRange;
+                run.firstX = kx;
+                run.lastX = kx;
+                run.weight = weight;
+                runs.push_back(run);
+            }
+        }
+    }
+}
+
+void SlidingWindowCpuEngine::step(CpuWorld& world)
+{
+    const int w = world.width;
+    const int h = world.height;
+    const int range = neighborSearchRange;
+    const int diameter = range * 2 + 1;
+
+    // Running sums of a row padded with range wrapped cells on both sides, entry i sums the first i padded cells
+    const int sumsWidth = w + 2 * range + 1;
+
+    const uint8_t* current = world.cells.data();
+    uint8_t* next = world.getScratch();
+
+    const TransitionTable& transitions = fixedPoint.transitions;
+
+    ThreadPool::parallelFor(0, h, [&](int rowBegin, int rowEnd)
+        {
+            // Sums wrap around as uint16, differences of at most 2r+1 cells are still exact
+            std::vector<uint16_t> rowSums((size_t)diameter * sumsWidth);
+            std::vector<int> cachedRows(diameter, -1);
+            std::vector<int16_t> sums(w);
+
+            auto getRowSums = [&](int worldRow) -> const uint16_t*
+                {
+                    int slot = worldRow % diameter;
+                    uint16_t* rowSum = rowSums.data() + (size_t)slot * sumsWidth;
+                    if (cachedRows[slot] != worldRow)
+                    {
+                        const uint8_t* source = current + (size_t)worldRow * w;
+                        uint16_t sum = 0;
+                        rowSum[0] = 0;
+                        for (int i = 0; i < sumsWidth - 1; ++i)
+                        {
+                            sum += source[((i - range) % w + w) % w];
+                            rowSum[i + 1] = sum;
+                        }
+                        cachedRows[slot] = worldRow;
+                    }
+                    return rowSum;
+                };
+
+            for (int y = rowBegin; y < rowEnd; ++y)
+            {
+                std::fill(sums.begin(), sums.end(), 0);
+                int16_t* cellSums = sums.data();
+                for (const WeightRun& run : runs)
+                {
+                    const uint16_t* rowSum = getRowSums(((y + run.dy) % h + h) % h);
+                    const uint16_t* runEnds = rowSum + run.lastX + 1;
+                    const uint16_t* runStarts = rowSum + run.firstX;
+                    const int16_t weight = run.weight;
+                    for (int x = 0; x < w; ++x)
+                    {
+                        cellSums[x] += (int16_t)((uint16_t)(runEnds[x] - runStarts[x]) * weight);
+                    }
+                }
+
+                const uint8_t* cells = current + (size_t)y * w;
+                uint8_t* nextCells = next + (size_t)y * w;
+                for (int x = 0; x < w; ++x)
+                {
+                    nextCells[x] = transitions.getNextState(cells[x], sums[x]);
+                }
+            }
+        });
+
+    world.swapBuffers();
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "CpuEngine.h"
+
+// SlidingWindowCpuEngine class for fixed-point kernels with long runs of equal weight along their rows.
+// Every window row keeps running sums of its cells, so a run of taps with one weight is the difference
+// of two running sums instead of one load per tap. Each thread keeps the running sums of the last 2r+1
+// rows it used, so a row is summed once per thread band.
+class SlidingWindowCpuEngine : public CpuEngine
+{
+public:
+    EngineType getType() const override;
+    bool supports(const SimulationRules& rules) const override;
+    void setRules(const SimulationRules& rules) override;
+    void step(CpuWorld& world) override;
+private:
+    // Taps [firstX, lastX] of one kernel row, as offsets into the padded row
+    struct WeightRun
+    {
+        int dy = 0;
+        int firstX = 0;
+        int lastX = 0;
+        int16_t weight = 0;
+    };
+
+    int neighborSearchRange = 1;
+    FixedPointRules fixedPoint;
+    std::vector<WeightRun> runs;
+};
@@ -0,0 +1,49 @@
+#include "SparseKernel.h"
+#include <algorithm>
+
+SparseKernel SparseKernel::compile(const SimulationRules& rules)
+{
+    SparseKernel sparse;
+    sparse.neighborSearchRange = rules.neighborSearchRange;
+    sparse.fixedPoint = rules.getFixedPointRules();
+    sparse.isGrouped = sparse.fixedPoint.isValid();
+
+    int range = rules.neighborSearchRange;
+    int diameter = range * 2 + 1;
+
+    // Non-zero taps in the order of the dense loop, y outer and x inner
+    std::vector<int> indices;
+    for (int index = 0; index < diameter * diameter && index < (int)rules.kernel.size(); ++index)
+    {
+        if (rules.kernel[index] != 0.0f)
+        {
+            indices.push_back(index);
+        }
+    }
+
+    if (sparse.isGrouped)
+    {
+        // Stable, so taps keep their dense order within a group
+        std::stable_sort(indices.begin(), indices.end(), [&rules](int a, int b) { return rules.kernel[a] < rules.kernel[b]; });
+    }
+
+    for (int index : indices)
+    {
+        float weight = rules.kernel[index];
+        if (!sparse.isGrouped || sparse.groups.empty() || sparse.groups.back().weight != weight)
+        {
+            KernelTapGroup group;
+            group.weight = weight;
+            group.fixedWeight = sparse.isGrouped ? sparse.fixedPoint.weights[index] : 0;
+            group.firstTap = (int)sparse.taps.size();
+            sparse.groups.push_back(group);
+        }
+
+        KernelTap tap;
+        tap.dx = index % diameter - range;
+        tap.dy = index / diameter - range;
+        sparse.taps.push_back(tap);
+        sparse.groups.back().tapCount++;
+    }
+    return sparse;
+}
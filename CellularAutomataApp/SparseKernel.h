@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "SimulationRules.h"
+
+struct KernelTap
+{
+    int dx = 0;
+    int dy = 0;
+};
+
+// Taps that share one weight, their cells are counted first and multiplied once.
+// Laid out like TapGroup in Shaders/automata.comp (std430).
+struct KernelTapGroup
+{
+    float weight = 0.0f;
+    int fixedWeight = 0; // Weight scaled by the fixed-point denominator
+    int firstTap = 0;
+    int tapCount = 0;
+};
+
+// SparseKernel struct, the kernel compiled into (dx, dy) taps with zero weights removed.
+// Skipping a zero weight only skips adding +0, so it is exact on every path. Grouping equal weights changes
+// the summation order, so it is only done for kernels with an exact fixed-point form; other kernels get one
+// group per tap in the order of the dense loop.
+struct SparseKernel
+{
+    int neighborSearchRange = 1;
+    bool isGrouped = false;
+    FixedPointRules fixedPoint;
+    std::vector<KernelTap> taps;
+    std::vector<KernelTapGroup> groups;
+
+    static SparseKernel compile(const SimulationRules& rules);
+};
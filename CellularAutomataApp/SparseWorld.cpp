@@ -0,0 +1,304 @@
+#include "SparseWorld.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include "Halo.h"
+#include "ThreadPool.h"
+#include "TraceRecorder.h"
+
+const size_t CHUNK_BYTES = (size_t)SparseWorld::CHUNK_SIZE * SparseWorld::CHUNK_SIZE;
+
+// Floor division, chunks of negative coordinates start below zero
+static int32_t floorDivide(int64_t value, int64_t divisor)
+{
+    return (int32_t)(value >= 0 ? value / divisor : (value - divisor + 1) / divisor);
+}
+
+SparseWorld::SparseWorld()
+    : pool(CHUNK_BYTES)
+{
+    setRules(SimulationRules(), EngineType::ScalarCpu);
+}
+
+SparseWorld::~SparseWorld()
+{
+    clear();
+}
+
+bool SparseWorld::setRules(const SimulationRules& rules, EngineType engineType)
+{
+    TransitionRanges ranges;
+    ranges.set(rules);
+    if (ranges.apply(0, 0.0f) != 0 || rules.neighborSearchRange > CHUNK_SIZE)
+    {
+        return false;
+    }
+
+    std::vector<std::unique_ptr<CpuEngine>> newEngines;
+    for (int i = 0; i < ThreadPool::getThreadCount(); ++i)
+    {
+        std::unique_ptr<CpuEngine> engine = CpuEngine::create(engineType);
+        if (!engine || !engine->supports(rules))
+        {
+            return false;
+        }
+        engine->setRules(rules);
+        newEngines.push_back(std::move(engine));
+    }
+    engines = std::move(newEngines);
+
+    while (poolCaches.size() < engines.size())
+    {
+        poolCaches.emplace_back(pool);
+    }
+
+    neighborSearchRange = rules.neighborSearchRange;
+    chunkWorlds.resize(engines.size());
+    for (CpuWorld& world : chunkWorlds)
+    {
+        world.resize(CHUNK_SIZE + 2 * neighborSearchRange, CHUNK_SIZE + 2 * neighborSearchRange);
+    }
+    return true;
+}
+
+void SparseWorld::clear()
+{
+    freeChunks(chunks);
+    chunks.clear();
+}
+
+ChunkCoord SparseWorld::getChunkCoord(int64_t x, int64_t y)
+{
+    return { floorDivide(x, CHUNK_SIZE), floorDivide(y, CHUNK_SIZE) };
+}
+
+uint8_t* SparseWorld::getOrCreateChunk(ChunkCoord coord)
+{
+    uint8_t* cells = chunks.find(coord);
+    if (!cells)
+    {
+        cells = static_cast<uint8_t*>(pool.allocate());
+        memset(cells, 0, CHUNK_BYTES);
+        chunks.insert(coord, cells);
+    }
+    return cells;
+}
+
+void SparseWorld::setCell(int64_t x, int64_t y, uint8_t state)
+{
+    ChunkCoord coord = getChunkCoord(x, y);
+    uint8_t* cells = state ? getOrCreateChunk(coord) : chunks.find(coord);
+    if (cells)
+    {
+        cells[(y - (int64_t)coord.y * CHUNK_SIZE) * CHUNK_SIZE + (x - (int64_t)coord.x * CHUNK_SIZE)] = state;
+    }
+}
+
+uint8_t SparseWorld::getCell(int64_t x, int64_t y) const
+{
+    ChunkCoord coord = getChunkCoord(x, y);
+    const uint8_t* cells = chunks.find(coord);
+    return cells ? cells[(y - (int64_t)coord.y * CHUNK_SIZE) * CHUNK_SIZE + (x - (int64_t)coord.x * CHUNK_SIZE)] : 0;
+}
+
+void SparseWorld::randomize(int64_t x, int64_t y, int width, int height, float density, unsigned int seed)
+{
+    std::mt19937 engine(seed);
+    uint32_t threshold = static_cast<uint32_t>(density * 4294967295.0);
+    for (int row = 0; row < height; ++row)
+    {
+        for (int column = 0; column < width; ++column)
+        {
+            setCell(x + column, y + row, engine() < threshold ? 1 : 0);
+        }
+    }
+}
+
+void SparseWorld::getRegion(int64_t x, int64_t y, int width, int height, std::vector<uint8_t>& cells) const
+{
+    cells.assign((size_t)width * height, 0);
+    for (int row = 0; row < height; ++row)
+    {
+        for (int column = 0; column < width; ++column)
+        {
+            cells[(size_t)row * width + column] = getCell(x + column, y + row);
+        }
+    }
+}
+
+void SparseWorld::loadChunkWithHalo(ChunkCoord coord, CpuWorld& world) const
+{
+    const int range = neighborSearchRange;
+    const int worldW = world.width;
+
+    for (const HaloRegion& region : Halo::getRegions(CHUNK_SIZE, CHUNK_SIZE, range, range))
+    {
+        const uint8_t* chunk = chunks.find({ coord.x + region.neighborX, coord.y + region.neighborY });
+        for (int row = 0; row < region.rowsCount; ++row)
+        {
+            uint8_t* target = world.cells.data() + (size_t)(region.targetRow + row) * worldW + region.targetColumn;
+            if (chunk)
+            {
+                memcpy(target, chunk + (size_t)(region.sourceRow + row) * CHUNK_SIZE + region.sourceColumn, region.columnsCount);
+            }
+            else
+            {
+                memset(target, 0, region.columnsCount);
+            }
+        }
+    }
+}
+
+void SparseWorld::step()
+{
+    ScopedTraceEvent trace("Sparse world step", "simulation");
+
+    // Live chunks and the chunks next to them, nothing further away can be born
+    candidates.clear();
+    for (const ChunkMap::Entry& entry : chunks.getEntries())
+    {
+        if (entry.isUsed)
+        {
+            candidates.insert(entry.coord, entry.cells);
+        }
+    }
+    for (const ChunkMap::Entry& entry : chunks.getEntries())
+    {
+        if (!entry.isUsed)
+        {
+            continue;
+        }
+        for (int ny = -1; ny <= 1; ++ny)
+        {
+            for (int nx = -1; nx <= 1; ++nx)
+            {
+                candidates.insert({ entry.coord.x + nx, entry.coord.y + ny }, nullptr);
+            }
+        }
+    }
+
+    arena.reset();
+    const size_t coordsCount = candidates.getSize();
+    ChunkCoord* coords = arena.allocateArray<ChunkCoord>(coordsCount);
+    uint8_t** nextCells = arena.allocateArray<uint8_t*>(coordsCount);
+    size_t coordIndex = 0;
+    for (const ChunkMap::Entry& entry : candidates.getEntries())
+    {
+        if (entry.isUsed)
+        {
+            coords[coordIndex++] = entry.coord;
+        }
+    }
+
+    const int range = neighborSearchRange;
+    const int threadsCount = (int)engines.size();
+    ThreadPool::parallelFor(0, threadsCount, [&](int threadBegin, int threadEnd)
+        {
+            for (int thread = threadBegin; thread < threadEnd; ++thread)
+            {
+                CpuEngine& engine = *engines[thread];
+                CpuWorld& world = chunkWorlds[thread];
+                FixedBlockPool::ThreadCache& poolCache = poolCaches[thread];
+                for (size_t i = thread; i < coordsCount; i += threadsCount)
+                {
+                    loadChunkWithHalo(coords[i], world);
+                    engine.invalidate();
+                    engine.step(world);
+
+                    uint8_t* cells = static_cast<uint8_t*>(poolCache.allocate());
+                    uint8_t alive = 0;
+                    for (int row = 0; row < CHUNK_SIZE; ++row)
+                    {
+                        const uint8_t* source = world.cells.data() + (size_t)(row + range) * world.width + range;
+                        memcpy(cells + (size_t)row * CHUNK_SIZE, source, CHUNK_SIZE);
+                        for (int column = 0; column < CHUNK_SIZE; ++column)
+                        {
+                            alive |= source[column];
+                        }
+                    }
+
+                    // Empty chunks are freed right away
+                    if (!alive)
+                    {
+                        poolCache.deallocate(cells);
+                        cells = nullptr;
+                    }
+                    nextCells[i] = cells;
+                }
+            }
+        });
+
+    nextChunks.clear();
+    for (size_t i = 0; i < coordsCount; ++i)
+    {
+        if (nextCells[i])
+        {
+            nextChunks.insert(coords[i], nextCells[i]);
+        }
+    }
+    freeChunks(chunks);
+    std::swap(chunks, nextChunks);
+
+    steppedChunksCount = coordsCount;
+    generation++;
+}
+
+void SparseWorld::freeChunks(ChunkMap& map)
+{
+    // Only called outside of the parallel part of a step, so the first cache is free to use
+    FixedBlockPool::ThreadCache& poolCache = poolCaches.front();
+    for (const ChunkMap::Entry& entry : map.getEntries())
+    {
+        if (entry.isUsed)
+        {
+            poolCache.deallocate(entry.cells);
+        }
+    }
+}
+
+uint64_t SparseWorld::getGeneration() const
+{
+    return generation;
+}
+
+size_t SparseWorld::getChunksCount() const
+{
+    return chunks.getSize();
+}
+
+size_t SparseWorld::getSteppedChunksCount() const
+{
+    return steppedChunksCount;
+}
+
+bool SparseWorld::run(const SparseWorldConfig& config, const EngineCostModel& costModel)
+{
+    SparseWorld world;
+    SimulationRules rules;
+    int windowSize = CHUNK_SIZE + 2 * rules.neighborSearchRange;
+    EngineType engineType = costModel.selectCpuEngine(rules, windowSize * windowSize);
+    if (engineType == EngineType::COUNT_ || !world.setRules(rules, engineType))
+    {
+        std::cerr << "The sparse world does not support these rules" << std::endl;
+        return false;
+    }
+
+    world.randomize(-config.seedSize / 2, -config.seedSize / 2, config.seedSize, config.seedSize, config.density, config.seed);
+    std::cout << "Sparse world, " << config.seedSize << "x" << config.seedSize << " seed, engine: " << ENGINE_TYPE_NAMES[static_cast<int>(engineType)] << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < config.generations; ++i)
+    {
+        world.step();
+        if ((i + 1) % 100 == 0 || i + 1 == config.generations)
+        {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "Generation " << world.getGeneration() << ": " << world.getChunksCount() << " live chunks, "
+                << world.getSteppedChunksCount() << " stepped, " << seconds << " s, pool of " << world.pool.getCapacityBlocks() << " chunks"
+                << (world.pool.isUsingHugePages() ? " in huge pages" : "") << std::endl;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "ChunkMap.h"
+#include "CpuEngine.h"
+#include "EngineCostModel.h"
+#include "FixedBlockPool.h"
+#include "GenerationArena.h"
+
+struct SparseWorldConfig
+{
+    int generations = 1000;
+    int seedSize = 256; // Random square at the origin
+    float density = 0.3f;
+    unsigned int seed = 12345;
+};
+
+// SparseWorld class, an unbounded plane of cells stored as CHUNK_SIZE square chunks.
+// Only chunks with a live cell exist; they live in a ChunkMap and their cells come from a FixedBlockPool.
+// A generation steps every chunk and its 8 neighbors: each one is copied with an r cell halo into a small
+// CpuWorld and stepped by a CPU engine, chunks that end up empty are freed. So the cost follows the live area.
+// Rules where an empty neighborhood gives birth would fill the plane and are not supported.
+class SparseWorld
+{
+public:
+    static const int CHUNK_SIZE = 64;
+
+    SparseWorld();
+    SparseWorld(const SparseWorld&) = delete;
+    SparseWorld& operator=(const SparseWorld&) = delete;
+    ~SparseWorld();
+
+    // Seeds a random square at the origin and steps it with the fastest CPU engine, reports the live area
+    static bool run(const SparseWorldConfig& config, const EngineCostModel& costModel);
+
+    bool setRules(const SimulationRules& rules, EngineType engineType);
+    void clear();
+    void setCell(int64_t x, int64_t y, uint8_t state);
+    uint8_t getCell(int64_t x, int64_t y) const;
+    void randomize(int64_t x, int64_t y, int width, int height, float density, unsigned int seed);
+    void getRegion(int64_t x, int64_t y, int width, int height, std::vector<uint8_t>& cells) const;
+    void step();
+
+    uint64_t getGeneration() const;
+    size_t getChunksCount() const;
+    size_t getSteppedChunksCount() const; // In the last generation
+private:
+    ChunkMap chunks;
+    ChunkMap nextChunks;
+    ChunkMap candidates; // Chunks to step, with nullptr cells for the empty neighbors
+    FixedBlockPool pool;
+    GenerationArena arena; // Candidate lists of one step
+
+    // One engine, halo world and pool cache per thread, engines keep state between the chunks they step
+    std::vector<std::unique_ptr<CpuEngine>> engines;
+    std::vector<CpuWorld> chunkWorlds;
+    std::vector<FixedBlockPool::ThreadCache> poolCaches;
+    int neighborSearchRange = 1;
+
+    uint64_t generation = 0;
+    size_t steppedChunksCount = 0;
+
+    static ChunkCoord getChunkCoord(int64_t x, int64_t y);
+    uint8_t* getOrCreateChunk(ChunkCoord coord);
+    void loadChunkWithHalo(ChunkCoord coord, CpuWorld& world) const;
+    void freeChunks(ChunkMap& map);
+};
@@ -1,5 +1,6 @@
 #include "Texture2D.h"
 #include <random>
+#include "TraceRecorder.h"
 
 Texture2D::Texture2D(int width, int height, GLenum internalFormat, GLenum format, GLenum type)
     : width(width), height(height), internalFormat(internalFormat), format(format), type(type)
@@ -67,7 +68,10 @@ void Texture2D::bind(GLenum textureUnit) const
 
 void Texture2D::setData(const void* data)
 {
+    ScopedTraceEvent trace("Texture upload", "gl");
+
     glBindTexture(GL_TEXTURE_2D, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glTexSubImage2D(
         GL_TEXTURE_2D,
         0,
@@ -112,3 +116,13 @@ GLenum Texture2D::getInternalFormat() const
 {
     return internalFormat;
 }
+
+GLenum Texture2D::getFormat() const
+{
+    return format;
+}
+
+GLenum Texture2D::getType() const
+{
+    return type;
+}
@@ -27,6 +27,8 @@ public:
     int getWidth() const;
     int getHeight() const;
     GLenum getInternalFormat() const;
+    GLenum getFormat() const;
+    GLenum getType() const;
 private:
     GLuint textureID;
     int width;
@@ -0,0 +1,120 @@
+#include "TextureReadback.h"
+#include <algorithm>
+
+TextureReadback::TextureReadback(int width, int height, int ringSize)
+    : width(width), height(height), frameSize((GLsizeiptr)width * height)
+{
+    const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    slots.resize(std::max(ringSize, 1));
+    for (Slot& slot : slots)
+    {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferStorage(GL_PIXEL_PACK_BUFFER, frameSize, nullptr, flags);
+        slot.mapped = static_cast<const uint8_t*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, flags));
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+TextureReadback::~TextureReadback()
+{
+    for (Slot& slot : slots)
+    {
+        if (slot.fence)
+        {
+            glDeleteSync(slot.fence);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glDeleteBuffers(1, &slot.pbo);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+bool TextureReadback::request(const Texture2D& texture, uint64_t generation)
+{
+    // Every buffer is still being written by the GPU, skip this generation rather than wait
+    if (pendingCount == (int)slots.size())
+    {
+        droppedCount++;
+        return false;
+    }
+
+    Slot& slot = slots[(oldestSlot + pendingCount) % slots.size()];
+    slot.generation = generation;
+
+    // Compute shader image stores have to be visible to the texture read below
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTextureImage(texture.getID(), 0, texture.getFormat(), texture.getType(), (GLsizei)frameSize, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pendingCount++;
+    return true;
+}
+
+void TextureReadback::poll()
+{
+    // Copies finish in submission order, so stop at the first one that is not ready yet
+    while (pendingCount > 0)
+    {
+        Slot& slot = slots[oldestSlot];
+
+        GLint status = GL_UNSIGNALED;
+        glGetSynciv(slot.fence, GL_SYNC_STATUS, 1, nullptr, &status);
+        if (status != GL_SIGNALED)
+        {
+            break;
+        }
+
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        ReadbackFrame frame;
+        frame.data = slot.mapped;
+        frame.width = width;
+        frame.height = height;
+        frame.generation = slot.generation;
+        for (auto& consumer : consumers)
+        {
+            consumer.second(frame);
+        }
+
+        oldestSlot = (oldestSlot + 1) % slots.size();
+        pendingCount--;
+    }
+}
+
+int TextureReadback::addConsumer(Consumer consumer)
+{
+    int id = nextConsumerID++;
+    consumers.emplace_back(id, std::move(consumer));
+    return id;
+}
+
+void TextureReadback::removeConsumer(int id)
+{
+    consumers.erase(
+        std::remove_if(consumers.begin(), consumers.end(), [id](const auto& c) { return c.first == id; }),
+        consumers.end()
+    );
+}
+
+bool TextureReadback::hasConsumers() const
+{
+    return !consumers.empty();
+}
+
+int TextureReadback::getPendingCount() const
+{
+    return pendingCount;
+}
+
+uint64_t TextureReadback::getDroppedCount() const
+{
+    return droppedCount;
+}
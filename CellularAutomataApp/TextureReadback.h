@@ -0,0 +1,60 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "Texture2D.h"
+
+// Cell data of one generation copied back from the GPU
+struct ReadbackFrame
+{
+    const uint8_t* data = nullptr;
+    int width = 0;
+    int height = 0;
+    uint64_t generation = 0;
+};
+
+// TextureReadback class for copying textures to the CPU without stalling.
+// Each request copies the texture into one of a ring of persistently mapped pixel buffer objects
+// and places a fence behind it. poll() hands finished copies to the consumers a few frames later;
+// when every buffer is still in flight the request is dropped instead of waiting on the driver.
+class TextureReadback
+{
+public:
+    using Consumer = std::function<void(const ReadbackFrame&)>;
+
+    TextureReadback(int width, int height, int ringSize = 3);
+    ~TextureReadback();
+    TextureReadback(const TextureReadback&) = delete;
+    TextureReadback& operator=(const TextureReadback&) = delete;
+
+    bool request(const Texture2D& texture, uint64_t generation);
+    void poll();
+
+    int addConsumer(Consumer consumer);
+    void removeConsumer(int id);
+    bool hasConsumers() const;
+
+    int getPendingCount() const;
+    uint64_t getDroppedCount() const;
+private:
+    struct Slot
+    {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        const uint8_t* mapped = nullptr;
+        uint64_t generation = 0;
+    };
+
+    int width;
+    int height;
+    GLsizeiptr frameSize;
+
+    std::vector<Slot> slots;
+    int oldestSlot = 0;
+    int pendingCount = 0;
+    uint64_t droppedCount = 0;
+
+    std::vector<std::pair<int, Consumer>> consumers;
+    int nextConsumerID = 0;
+};
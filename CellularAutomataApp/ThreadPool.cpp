@@ -0,0 +1,147 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool
+{
+public:
+    WorkerPool()
+    {
+        int workersCount = std::max(1, (int)std::thread::hardware_concurrency()) - 1;
+        for (int i = 0; i < workersCount; ++i)
+        {
+            workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isStopping = true;
+        }
+        wakeCondition.notify_all();
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    int getThreadCount() const
+    {
+        return (int)workers.size() + 1;
+    }
+
+    void run(int begin, int end, const std::function<void(int, int)>& body)
+    {
+        std::lock_guard<std::mutex> submitLock(submitMutex);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &body;
+            jobEnd = end;
+            chunkSize = std::max(1, (end - begin) / (getThreadCount() * 4));
+            nextIndex.store(begin);
+            busyWorkers = (int)workers.size();
+            jobID++;
+        }
+        wakeCondition.notify_all();
+
+        // The calling thread works on the job too
+        isInsideJob = true;
+        processChunks();
+        isInsideJob = false;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCondition.wait(lock, [this]() { return busyWorkers == 0; });
+        job = nullptr;
+    }
+
+    static thread_local bool isInsideJob;
+private:
+    std::vector<std::thread> workers;
+    std::mutex submitMutex;
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+
+    const std::function<void(int, int)>* job = nullptr;
+    int jobEnd = 0;
+    int chunkSize = 1;
+    std::atomic<int> nextIndex{ 0 };
+    int busyWorkers = 0;
+    uint64_t jobID = 0;
+    bool isStopping = false;
+
+    void processChunks()
+    {
+        while (true)
+        {
+            int chunkBegin = nextIndex.fetch_add(chunkSize);
+            if (chunkBegin >= jobEnd)
+            {
+                break;
+            }
+            (*job)(chunkBegin, std::min(chunkBegin + chunkSize, jobEnd));
+        }
+    }
+
+    void workerLoop()
+    {
+        isInsideJob = true;
+        uint64_t seenJobID = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeCondition.wait(lock, [&]() { return isStopping || jobID != seenJobID; });
+                if (isStopping)
+                {
+                    return;
+                }
+                seenJobID = jobID;
+            }
+
+            processChunks();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busyWorkers == 0)
+            {
+                doneCondition.notify_one();
+            }
+        }
+    }
+};
+
+thread_local bool WorkerPool::isInsideJob = false;
+
+static WorkerPool& getPool()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+int ThreadPool::getThreadCount()
+{
+    return getPool().getThreadCount();
+}
+
+void ThreadPool::parallelFor(int begin, int end, const std::function<void(int, int)>& body)
+{
+    if (end <= begin)
+    {
+        return;
+    }
+
+    if (WorkerPool::isInsideJob || getPool().getThreadCount() == 1 || end - begin == 1)
+    {
+        body(begin, end);
+        return;
+    }
+    getPool().run(begin, end, body);
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <functional>
+
+// ThreadPool class for splitting loops over rows between persistent worker threads
+class ThreadPool
+{
+public:
+    ThreadPool() = delete;
+
+    static int getThreadCount();
+
+    // Calls body(chunkBegin, chunkEnd) for disjoint chunks covering [begin, end) and waits for all of them.
+    // Nested calls from inside a body run serially on the calling worker.
+    static void parallelFor(int begin, int end, const std::function<void(int, int)>& body);
+};
@@ -0,0 +1,314 @@
+#include "TileStore.h"
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static const char TILE_STORE_MAGIC[4] = { 'C', 'A', 'T', 'S' };
+static const uint32_t TILE_STORE_VERSION = 1;
+
+TileStore::~TileStore()
+{
+    close();
+}
+
+bool TileStore::create(const std::filesystem::path& path, int64_t width, int64_t height, int tileSize)
+{
+    close();
+    if (tileSize <= 0 || tileSize % TILE_SIZE_ALIGNMENT != 0 || width <= 0 || height <= 0 || width % tileSize != 0 || height % tileSize != 0)
+    {
+        std::cerr << "Tile store size has to be a multiple of a tile size that is a multiple of " << TILE_SIZE_ALIGNMENT << std::endl;
+        return false;
+    }
+
+    uint64_t tilesCount = (uint64_t)(width / tileSize) * (uint64_t)(height / tileSize);
+    uint64_t size = HEADER_BYTES + tilesCount * BUFFERS_COUNT * (uint64_t)tileSize * tileSize;
+    if (!openFile(path, true, size))
+    {
+        return false;
+    }
+
+    header = reinterpret_cast<Header*>(mapView(0, HEADER_BYTES));
+    if (!header)
+    {
+        close();
+        return false;
+    }
+    memcpy(header->magic, TILE_STORE_MAGIC, sizeof(TILE_STORE_MAGIC));
+    header->version = TILE_STORE_VERSION;
+    header->width = width;
+    header->height = height;
+    header->tileSize = tileSize;
+    header->reserved = 0;
+    header->generation = 0;
+    return true;
+}
+
+bool TileStore::open(const std::filesystem::path& path)
+{
+    close();
+    if (!openFile(path, false, 0))
+    {
+        return false;
+    }
+
+    header = reinterpret_cast<Header*>(mapView(0, HEADER_BYTES));
+    if (!header || memcmp(header->magic, TILE_STORE_MAGIC, sizeof(TILE_STORE_MAGIC)) != 0 || header->version != TILE_STORE_VERSION)
+    {
+        std::cerr << "Not a tile store: " << path.string() << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TileStore::close()
+{
+    for (const CachedTile& tile : cache)
+    {
+        unmapView(tile.data, getTileBytes());
+    }
+    cache.clear();
+    cacheIndex.clear();
+
+    if (header)
+    {
+        unmapView(reinterpret_cast<uint8_t*>(header), HEADER_BYTES);
+        header = nullptr;
+    }
+
+#ifdef _WIN32
+    if (mapping)
+    {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    if (file)
+    {
+        CloseHandle(file);
+        file = nullptr;
+    }
+#else
+    if (file >= 0)
+    {
+        ::close(file);
+        file = -1;
+    }
+#endif
+}
+
+void TileStore::flush()
+{
+    for (const CachedTile& tile : cache)
+    {
+        flushView(tile.data, getTileBytes());
+    }
+    if (header)
+    {
+        flushView(reinterpret_cast<uint8_t*>(header), HEADER_BYTES);
+    }
+}
+
+int64_t TileStore::getWidth() const
+{
+    return header->width;
+}
+
+int64_t TileStore::getHeight() const
+{
+    return header->height;
+}
+
+int TileStore::getTileSize() const
+{
+    return header->tileSize;
+}
+
+int TileStore::getTilesX() const
+{
+    return (int)(header->width / header->tileSize);
+}
+
+int TileStore::getTilesY() const
+{
+    return (int)(header->height / header->tileSize);
+}
+
+uint64_t TileStore::getGeneration() const
+{
+    return header->generation;
+}
+
+void TileStore::setGeneration(uint64_t generation)
+{
+    header->generation = generation;
+}
+
+uint8_t* TileStore::getTile(int buffer, int tileX, int tileY)
+{
+    bool isNewlyMapped = false;
+    return mapTile(getTileIndex(buffer, tileX, tileY), isNewlyMapped);
+}
+
+void TileStore::prefetchTile(int buffer, int tileX, int tileY)
+{
+    bool isNewlyMapped = false;
+    uint8_t* data = mapTile(getTileIndex(buffer, tileX, tileY), isNewlyMapped);
+    if (isNewlyMapped)
+    {
+        prefetchView(data, getTileBytes());
+    }
+}
+
+uint64_t TileStore::getCacheMisses() const
+{
+    return cacheMisses;
+}
+
+size_t TileStore::getTileBytes() const
+{
+    return (size_t)header->tileSize * header->tileSize;
+}
+
+uint64_t TileStore::getTileIndex(int buffer, int tileX, int tileY) const
+{
+    return ((uint64_t)buffer * getTilesY() + tileY) * getTilesX() + tileX;
+}
+
+uint8_t* TileStore::mapTile(uint64_t index, bool& isNewlyMapped)
+{
+    auto it = cacheIndex.find(index);
+    if (it != cacheIndex.end())
+    {
+        cache.splice(cache.begin(), cache, it->second);
+        isNewlyMapped = false;
+        return cache.front().data;
+    }
+
+    while (!cache.empty() && cache.size() >= maxCachedTiles)
+    {
+        unmapView(cache.back().data, getTileBytes());
+        cacheIndex.erase(cache.back().index);
+        cache.pop_back();
+    }
+
+    uint8_t* data = mapView(HEADER_BYTES + index * getTileBytes(), getTileBytes());
+    if (!data)
+    {
+        return nullptr;
+    }
+    cache.push_front({ index, data });
+    cacheIndex[index] = cache.begin();
+    cacheMisses++;
+    isNewlyMapped = true;
+    return data;
+}
+
+#ifdef _WIN32
+
+bool TileStore::openFile(const std::filesystem::path& path, bool isCreating, uint64_t size)
+{
+    file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, isCreating ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        file = nullptr;
+        std::cerr << "Failed to open tile store: " << path.string() << std::endl;
+        return false;
+    }
+
+    if (isCreating)
+    {
+        LARGE_INTEGER end;
+        end.QuadPart = (LONGLONG)size;
+        if (!SetFilePointerEx(file, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file))
+        {
+            std::cerr << "Failed to resize tile store: " << path.string() << std::endl;
+            close();
+            return false;
+        }
+    }
+
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    if (!mapping)
+    {
+        std::cerr << "Failed to map tile store: " << path.string() << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+uint8_t* TileStore::mapView(uint64_t offset, size_t bytes)
+{
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, (DWORD)(offset >> 32), (DWORD)(offset & 0xFFFFFFFF), bytes);
+    return static_cast<uint8_t*>(data);
+}
+
+void TileStore::unmapView(uint8_t* data, size_t bytes)
+{
+    UnmapViewOfFile(data);
+}
+
+void TileStore::prefetchView(uint8_t* data, size_t bytes)
+{
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = data;
+    range.NumberOfBytes = bytes;
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+void TileStore::flushView(uint8_t* data, size_t bytes)
+{
+    FlushViewOfFile(data, bytes);
+}
+
+#else
+
+bool TileStore::openFile(const std::filesystem::path& path, bool isCreating, uint64_t size)
+{
+    file = ::open(path.c_str(), isCreating ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+    if (file < 0)
+    {
+        std::cerr << "Failed to open tile store: " << path.string() << std::endl;
+        return false;
+    }
+
+    // Sparse, untouched tiles read as dead cells
+    if (isCreating && ftruncate(file, (off_t)size) != 0)
+    {
+        std::cerr << "Failed to resize tile store: " << path.string() << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+uint8_t* TileStore::mapView(uint64_t offset, size_t bytes)
+{
+    void* data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, (off_t)offset);
+    return data == MAP_FAILED ? nullptr : static_cast<uint8_t*>(data);
+}
+
+void TileStore::unmapView(uint8_t* data, size_t bytes)
+{
+    munmap(data, bytes);
+}
+
+void TileStore::prefetchView(uint8_t* data, size_t bytes)
+{
+    madvise(data, bytes, MADV_WILLNEED);
+}
+
+void TileStore::flushView(uint8_t* data, size_t bytes)
+{
+    msync(data, bytes, MS_ASYNC);
+}
+
+#endif
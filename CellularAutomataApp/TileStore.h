@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <unordered_map>
+
+// TileStore class, a world larger than RAM stored as square tiles in a memory-mapped file.
+// The file holds two generations, each tile is contiguous so a tile is one view of the file.
+// Mapped tiles are kept in an LRU cache of maxCachedTiles views, evicted views are written back by the OS.
+class TileStore
+{
+public:
+    static const int HEADER_BYTES = 1 << 16;    // Keeps tile views aligned to the 64 KB mapping granularity of Windows
+    static const int TILE_SIZE_ALIGNMENT = 256; // 256x256 cells are 64 KB
+    static const int BUFFERS_COUNT = 2;
+
+    TileStore() = default;
+    ~TileStore();
+    TileStore(const TileStore&) = delete;
+    TileStore& operator=(const TileStore&) = delete;
+
+    bool create(const std::filesystem::path& path, int64_t width, int64_t height, int tileSize);
+    bool open(const std::filesystem::path& path);
+    void close();
+    void flush();
+
+    int64_t getWidth() const;
+    int64_t getHeight() const;
+    int getTileSize() const;
+    int getTilesX() const;
+    int getTilesY() const;
+    uint64_t getGeneration() const;
+    void setGeneration(uint64_t generation);
+
+    // Valid until maxCachedTiles other tiles are requested
+    uint8_t* getTile(int buffer, int tileX, int tileY);
+
+    // Asks the OS to start reading the tile, without waiting for it
+    void prefetchTile(int buffer, int tileX, int tileY);
+
+    uint64_t getCacheMisses() const;
+    size_t maxCachedTiles = 64;
+private:
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        int64_t width;
+        int64_t height;
+        int32_t tileSize;
+        int32_t reserved;
+        uint64_t generation;
+    };
+
+    struct CachedTile
+    {
+        uint64_t index;
+        uint8_t* data;
+    };
+
+    Header* header = nullptr;
+    std::list<CachedTile> cache; // Most recently used first
+    std::unordered_map<uint64_t, std::list<CachedTile>::iterator> cacheIndex;
+    uint64_t cacheMisses = 0;
+
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int file = -1;
+#endif
+
+    bool openFile(const std::filesystem::path& path, bool isCreating, uint64_t size);
+    uint8_t* mapView(uint64_t offset, size_t bytes);
+    void unmapView(uint8_t* data, size_t bytes);
+    void prefetchView(uint8_t* data, size_t bytes);
+    void flushView(uint8_t* data, size_t bytes);
+
+    size_t getTileBytes() const;
+    uint64_t getTileIndex(int buffer, int tileX, int tileY) const;
+    uint8_t* mapTile(uint64_t index, bool& isNewlyMapped);
+};
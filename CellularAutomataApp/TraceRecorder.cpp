@@ -0,0 +1,255 @@
+#include "TraceRecorder.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "CpuProfiler.h"
+
+struct TraceSlot
+{
+    std::atomic<bool> isReady{ false };
+    const char* name = nullptr;
+    const char* category = nullptr;
+    char detail[TraceRecorder::MAX_DETAIL_LENGTH] = {};
+    int64_t startNs = 0;
+    int64_t endNs = 0;
+    uint32_t threadID = 0;
+};
+
+std::atomic<bool> TraceRecorder::enabled{ false };
+
+static std::unique_ptr<TraceSlot[]> slotStorage;
+static std::atomic<TraceSlot*> slots{ nullptr };
+static std::atomic<int> claimedCount{ 0 };
+static std::atomic<uint64_t> droppedCount{ 0 };
+static std::atomic<int64_t> gpuClockOffsetNs{ 0 };
+static std::atomic<int> activeWriters{ 0 }; // Between claiming a slot and publishing it, see clear()
+
+static std::mutex threadNamesMutex;
+static std::vector<std::pair<uint32_t, std::string>> threadNames;
+static std::atomic<uint32_t> nextThreadID{ 1 };
+
+static uint32_t getThreadID()
+{
+    static thread_local uint32_t threadID = nextThreadID.fetch_add(1, std::memory_order_relaxed);
+    return threadID;
+}
+
+static TraceSlot* claimSlot()
+{
+    TraceSlot* storage = slots.load(std::memory_order_acquire);
+    int index = claimedCount.load(std::memory_order_relaxed) < TraceRecorder::MAX_EVENTS ? claimedCount.fetch_add(1, std::memory_order_relaxed) : TraceRecorder::MAX_EVENTS;
+    if (!storage || index >= TraceRecorder::MAX_EVENTS)
+    {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return &storage[index];
+}
+
+static void writeEscaped(std::ostream& out, const char* text)
+{
+    for (const char* c = text; *c; ++c)
+    {
+        switch (*c)
+        {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if ((unsigned char)*c >= 0x20)
+                {
+                    out << *c;
+                }
+                break;
+        }
+    }
+}
+
+void TraceRecorder::setEnabled(bool isEnabled)
+{
+    if (isEnabled && !slotStorage)
+    {
+        slotStorage = std::make_unique<TraceSlot[]>(MAX_EVENTS);
+        slots.store(slotStorage.get(), std::memory_order_release);
+    }
+    enabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+void TraceRecorder::clear()
+{
+    // Writers count themselves before they check that recording is enabled, so once it is disabled
+    // and the count reaches zero no slot of the old session can still be written
+    bool wasEnabled = enabled.exchange(false);
+    while (activeWriters.load() > 0)
+    {
+        std::this_thread::yield();
+    }
+
+    int count = std::min(claimedCount.load(), MAX_EVENTS);
+    for (int i = 0; i < count; ++i)
+    {
+        slotStorage[i].isReady.store(false, std::memory_order_relaxed);
+    }
+    claimedCount.store(0);
+    droppedCount.store(0);
+    enabled.store(wasEnabled, std::memory_order_relaxed);
+}
+
+void TraceRecorder::setThreadName(const char* name)
+{
+    std::lock_guard<std::mutex> lock(threadNamesMutex);
+    threadNames.emplace_back(getThreadID(), name);
+}
+
+void TraceRecorder::calibrateGpuClock()
+{
+    // GL_TIMESTAMP returns the GPU time right now without waiting for queued commands
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    gpuClockOffsetNs.store(CpuProfiler::now() - gpuNow);
+}
+
+void TraceRecorder::addCpuEvent(const char* name, const char* category, int64_t startNs, int64_t endNs, const char* detail)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+
+    activeWriters.fetch_add(1);
+    TraceSlot* slot = enabled.load() ? claimSlot() : nullptr;
+    if (!slot)
+    {
+        activeWriters.fetch_sub(1);
+        return;
+    }
+
+    slot->name = name;
+    slot->category = category;
+    slot->detail[0] = '\0';
+    if (detail)
+    {
+        strncpy(slot->detail, detail, MAX_DETAIL_LENGTH - 1);
+        slot->detail[MAX_DETAIL_LENGTH - 1] = '\0';
+    }
+    slot->startNs = startNs;
+    slot->endNs = endNs;
+    slot->threadID = getThreadID();
+    slot->isReady.store(true, std::memory_order_release);
+    activeWriters.fetch_sub(1, std::memory_order_release);
+}
+
+void TraceRecorder::addGpuEvent(const char* name, uint64_t gpuStartNs, uint64_t gpuEndNs)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+
+    activeWriters.fetch_add(1);
+    TraceSlot* slot = enabled.load() ? claimSlot() : nullptr;
+    if (!slot)
+    {
+        activeWriters.fetch_sub(1);
+        return;
+    }
+
+    int64_t offset = gpuClockOffsetNs.load(std::memory_order_relaxed);
+    slot->name = name;
+    slot->category = "gpu";
+    slot->detail[0] = '\0';
+    slot->startNs = (int64_t)gpuStartNs + offset;
+    slot->endNs = (int64_t)gpuEndNs + offset;
+    slot->threadID = GPU_THREAD_ID;
+    slot->isReady.store(true, std::memory_order_release);
+    activeWriters.fetch_sub(1, std::memory_order_release);
+}
+
+int TraceRecorder::getEventCount()
+{
+    return std::min(claimedCount.load(std::memory_order_relaxed), MAX_EVENTS);
+}
+
+uint64_t TraceRecorder::getDroppedCount()
+{
+    return droppedCount.load(std::memory_order_relaxed);
+}
+
+bool TraceRecorder::save(const std::filesystem::path& path)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open trace file for writing: " << path.string() << std::endl;
+        return false;
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_THREAD_ID << ",\"args\":{\"name\":\"GPU\"}}";
+    {
+        std::lock_guard<std::mutex> lock(threadNamesMutex);
+        for (const auto& threadName : threadNames)
+        {
+            file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadName.first << ",\"args\":{\"name\":\"";
+            writeEscaped(file, threadName.second.c_str());
+            file << "\"}}";
+        }
+    }
+
+    // Timestamps are in microseconds
+    file.precision(3);
+    file << std::fixed;
+    int count = getEventCount();
+    for (int i = 0; i < count; ++i)
+    {
+        const TraceSlot& slot = slotStorage[i];
+        if (!slot.isReady.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+
+        file << ",\n{\"name\":\"";
+        writeEscaped(file, slot.name);
+        file << "\",\"cat\":\"";
+        writeEscaped(file, slot.category);
+        file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << slot.threadID
+            << ",\"ts\":" << slot.startNs / 1000.0
+            << ",\"dur\":" << (slot.endNs - slot.startNs) / 1000.0;
+        if (slot.detail[0] != '\0')
+        {
+            file << ",\"args\":{\"detail\":\"";
+            writeEscaped(file, slot.detail);
+            file << "\"}";
+        }
+        file << "}";
+    }
+    file << "\n]}\n";
+
+    std::cout << "Saved " << count << " trace events to " << path.string() << std::endl;
+    return true;
+}
+
+ScopedTraceEvent::ScopedTraceEvent(const char* name, const char* category, const std::string& detail)
+    : name(name), category(category)
+{
+    if (TraceRecorder::isEnabled())
+    {
+        this->detail = detail;
+        startNs = CpuProfiler::now();
+    }
+}
+
+ScopedTraceEvent::~ScopedTraceEvent()
+{
+    if (startNs >= 0)
+    {
+        TraceRecorder::addCpuEvent(name, category, startNs, CpuProfiler::now(), detail.c_str());
+    }
+}
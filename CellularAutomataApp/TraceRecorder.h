@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <filesystem>
+
+// TraceRecorder class for collecting timed events into a Chrome trace / Perfetto JSON file.
+// Events go into a fixed-capacity buffer claimed with an atomic counter, so recording is lock-free
+// and memory stays bounded; events past the capacity are counted as dropped.
+// While recording is disabled every entry point returns after a single relaxed atomic load.
+class TraceRecorder
+{
+public:
+    static const int MAX_EVENTS = 1 << 19;
+    static const int MAX_DETAIL_LENGTH = 96;
+    static const uint32_t GPU_THREAD_ID = 1000;
+
+    TraceRecorder() = delete;
+
+    static bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    static void setEnabled(bool isEnabled);
+    static void clear(); // Pauses recording until the writers that already claimed a slot are done
+
+    static void setThreadName(const char* name);
+    static void calibrateGpuClock();
+
+    static void addCpuEvent(const char* name, const char* category, int64_t startNs, int64_t endNs, const char* detail = nullptr);
+    static void addGpuEvent(const char* name, uint64_t gpuStartNs, uint64_t gpuEndNs);
+
+    static int getEventCount();
+    static uint64_t getDroppedCount();
+    static bool save(const std::filesystem::path& path);
+private:
+    static std::atomic<bool> enabled;
+};
+
+// ScopedTraceEvent class for recording the enclosing scope as a trace event
+class ScopedTraceEvent
+{
+public:
+    ScopedTraceEvent(const char* name, const char* category, const std::string& detail = std::string());
+    ~ScopedTraceEvent();
+    ScopedTraceEvent(const ScopedTraceEvent&) = delete;
+    ScopedTraceEvent& operator=(const ScopedTraceEvent&) = delete;
+private:
+    const char* name;
+    const char* category;
+    std::string detail;
+    int64_t startNs = -1;
+};
@@ -0,0 +1,37 @@
+#include "TripleBuffer.h"
+
+TripleBuffer::TripleBuffer(int writerSlotsCount)
+    : slotsCount(writerSlotsCount + 2), middleIndex(writerSlotsCount), readIndex(writerSlotsCount + 1)
+{
+}
+
+int TripleBuffer::getSlotsCount() const
+{
+    return slotsCount;
+}
+
+int TripleBuffer::publish(int slot)
+{
+    // Release makes the slot contents visible to the reader, acquire the reader's release of its old slot
+    return middleIndex.exchange(slot | NEWER_BIT, std::memory_order_acq_rel) & ~NEWER_BIT;
+}
+
+bool TripleBuffer::isNewerPublished() const
+{
+    return (middleIndex.load(std::memory_order_relaxed) & NEWER_BIT) != 0;
+}
+
+bool TripleBuffer::acquire()
+{
+    if (!isNewerPublished())
+    {
+        return false;
+    }
+    readIndex = middleIndex.exchange(readIndex, std::memory_order_acq_rel) & ~NEWER_BIT;
+    return true;
+}
+
+int TripleBuffer::getReadIndex() const
+{
+    return readIndex;
+}
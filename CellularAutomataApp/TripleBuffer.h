@@ -0,0 +1,28 @@
+#pragma once
+#include <atomic>
+
+// TripleBuffer class for handing the newest of a stream of values from one writer thread to one reader thread.
+// It only manages indices into slots owned by the caller: the writer fills one of its slots and swaps it
+// with the middle one, the reader swaps the middle slot with its front slot when a newer one was published.
+// Neither side ever waits, values the reader had no time for are overwritten. The writer may own more
+// than one slot, e.g. to keep several values in preparation; with one it is a classic triple buffer.
+class TripleBuffer
+{
+public:
+    explicit TripleBuffer(int writerSlotsCount = 1);
+    int getSlotsCount() const;
+
+    // Writer thread, slots [0, writerSlotsCount) start with the writer
+    int publish(int slot); // Returns the slot the writer gets back instead
+
+    // Reader thread
+    bool isNewerPublished() const;
+    bool acquire(); // The newest published slot becomes the front slot, false when there is none
+    int getReadIndex() const;
+private:
+    static const int NEWER_BIT = 1 << 30; // Set on the middle index by publish(), cleared by acquire()
+
+    int slotsCount;
+    std::atomic<int> middleIndex;
+    int readIndex;
+};
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_glfw.h"
@@ -18,12 +19,43 @@
 #include "Random.h"
 #include "ColorPalette.h"
 #include "WindowsFileDialog.h"
+#include "TextureReadback.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "ProfilerUI.h"
+#include "TraceRecorder.h"
+#include "Benchmark.h"
+#include "Conformance.h"
+#include "OutOfCoreSimulation.h"
+#include "SparseWorld.h"
+#include "RewindHistory.h"
+#include "SimulationThread.h"
 
 const int WINDOW_W = 1824;
 const int WINDOW_H = 1024;
 
 const int GRID_W = 512;
 const int GRID_H = 512;
+const int REWIND_BUDGET_MB = 256;
+
+struct CommandLineOptions
+{
+    std::string tracePath;
+    std::string benchmarkPath;
+    bool isQuickBenchmark = false;
+    std::string conformancePath;
+    bool isGeneratingGolden = false;
+    OutOfCoreConfig outOfCore;
+    bool isRunningSparseWorld = false;
+    SparseWorldConfig sparseWorld;
+};
+
+struct WorldStatistics
+{
+    bool isValid = false;
+    uint64_t generation = 0;
+    uint64_t population = 0;
+};
 
 GLFWwindow* initOpenGLWindow(int width, int height, const char* title)
 {
@@ -68,6 +100,57 @@ GLFWwindow* initOpenGLWindow(int width, int height, const char* title)
     return window;
 }
 
+CommandLineOptions parseCommandLine(int argc, char** argv)
+{
+    CommandLineOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--trace" && i + 1 < argc)
+        {
+            options.tracePath = argv[++i];
+        }
+        else if (arg == "--benchmark" && i + 1 < argc)
+        {
+            options.benchmarkPath = argv[++i];
+        }
+        else if (arg == "--benchmark-quick" && i + 1 < argc)
+        {
+            options.benchmarkPath = argv[++i];
+            options.isQuickBenchmark = true;
+        }
+        else if (arg == "--conformance" && i + 1 < argc)
+        {
+            options.conformancePath = argv[++i];
+        }
+        else if (arg == "--conformance-generate" && i + 1 < argc)
+        {
+            options.conformancePath = argv[++i];
+            options.isGeneratingGolden = true;
+        }
+        else if (arg == "--out-of-core" && i + 3 < argc)
+        {
+            options.outOfCore.storePath = argv[++i];
+            options.outOfCore.worldSize = std::stoll(argv[++i]);
+            options.outOfCore.generations = std::stoi(argv[++i]);
+        }
+        else if (arg == "--sparse-world" && i + 1 < argc)
+        {
+            options.isRunningSparseWorld = true;
+            options.sparseWorld.generations = std::stoi(argv[++i]);
+        }
+        else if (arg == "--tile-cache-mb" && i + 1 < argc)
+        {
+            options.outOfCore.cacheBytes = (size_t)std::stoll(argv[++i]) << 20;
+        }
+        else
+        {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+        }
+    }
+    return options;
+}
+
 void createQuadBuffers(VAO& vao, VBO& vbo, EBO& ebo, const float* vertices, size_t verticesSize, const unsigned int* indices, size_t indicesSize)
 {
     // Bind VAO
@@ -93,11 +176,23 @@ void createQuadBuffers(VAO& vao, VBO& vbo, EBO& ebo, const float* vertices, size
     vao.unbind();
 }
 
-void UI(Simulation& sim, Shader& cellsShader)
+// The simulation runs on its own thread, every change to it is posted as a command.
+// Settings are edited on a copy and sent at the end, so the rules are uploaded only when they changed.
+void UI(Simulation& sim, SimulationThread& simThread, Shader& cellsShader, const WorldStatistics& statistics, RewindHistory& history)
 {
+    SimulationSettings settings = simThread.getSettings();
+    const SimulationStatus& status = simThread.getFrameStatus();
+
+    // The settings edited so far go first, so the new cells are stepped with the rules they were made for
+    auto randomizeCells = [&simThread, &settings]()
+        {
+            simThread.postSettings(settings);
+            simThread.post([](Simulation& s) { s.randomize(); });
+        };
+
     ImGui::Begin("Cellular automata");
 
-    SimulationRules& rules = sim.rules;
+    SimulationRules& rules = settings.rules;
 	SimulationVisuals& visuals = sim.visuals;
 
     if (ImGui::BeginMainMenuBar())
@@ -160,22 +255,21 @@ void UI(Simulation& sim, Shader& cellsShader)
         if (ImGui::ListBox("Kernel randomization type", (int*)&rules.kernelRandomizationType, KERNEL_GENERATION_TYPE_NAMES, IM_ARRAYSIZE(KERNEL_GENERATION_TYPE_NAMES), (int)KernelGenerationType::COUNT_))
         {
             rules.randomizeKernel();
-			sim.randomize();
+			randomizeCells();
 		}
 
         ImGui::Text("Buttons:");
 
         if (ImGui::Button("Randomize cells"))
         {
-            sim.randomize();
+            randomizeCells();
         }
 
         ImGui::SameLine();
         if (ImGui::Button("Reset to default"))
         {
             rules = SimulationRules();
-            sim.submitRulesToShader();
-            sim.randomize();
+            randomizeCells();
         }
 
         // Randomize rules
@@ -196,7 +290,7 @@ void UI(Simulation& sim, Shader& cellsShader)
             rules.birthRange[0] = Random::Int(0, (int)maxNeighborSum);
             rules.birthRange[1] = Random::Int(rules.birthRange[0], (int)maxNeighborSum);
 
-            sim.randomize();
+            randomizeCells();
         }
     }
     ImGui::Dummy({ 0, 20 });
@@ -208,14 +302,54 @@ void UI(Simulation& sim, Shader& cellsShader)
         {
             ImGui::Text("Simulation settings:");
 
-            int previousUpdatesRate = sim.simulationUpdatesRate;
-            ImGui::SliderInt("Updates rate", &sim.simulationUpdatesRate, 0, 300);
-            if (sim.simulationUpdatesRate != previousUpdatesRate)
+            ImGui::SliderInt("Updates rate", &settings.updatesRate, 0, 300);
+
+            float frameBudgetMilliseconds = (float)(settings.frameBudgetSeconds * 1000.0);
+            if (ImGui::SliderFloat("Frame budget (ms)", &frameBudgetMilliseconds, 1.0f, 50.0f, "%.1f"))
+            {
+                settings.frameBudgetSeconds = frameBudgetMilliseconds / 1000.0;
+            }
+            ImGui::Text("Updates: %.1f / %d per second%s", status.achievedUpdatesRate, settings.updatesRate,
+                status.isLimitedByFrameBudget ? " (limited by the frame budget)" : "");
+
+            ImGui::Checkbox("Is running", &settings.isRunning);
+
+            // Fast-forward without showing the generations in between
+            static uint64_t generationsToAdvance = 100000;
+            if (status.isAdvancing)
+            {
+                ImGui::ProgressBar((float)status.advanceProgress, ImVec2(-1.0f, 0.0f));
+                if (ImGui::Button("Cancel"))
+                {
+                    simThread.post([](Simulation& s) { s.cancelAdvance(); });
+                }
+            }
+            else
+            {
+                ImGui::InputScalar("Generations", ImGuiDataType_U64, &generationsToAdvance);
+                ImGui::SameLine();
+                if (ImGui::Button("Advance"))
+                {
+                    simThread.post([count = generationsToAdvance](Simulation& s) { s.advanceGenerations(count); });
+                }
+            }
+
+            ImGui::Checkbox("Automatic engine", &settings.isEngineAutomatic);
+            if (!settings.isEngineAutomatic)
             {
-                sim.resetUpdatesCounter();
+                int engine = static_cast<int>(settings.manualEngine);
+                if (ImGui::Combo("Engine", &engine, ENGINE_TYPE_NAMES, static_cast<int>(EngineType::COUNT_)))
+                {
+                    settings.manualEngine = static_cast<EngineType>(engine);
+                }
             }
+            ImGui::Text("Active engine: %s", ENGINE_TYPE_NAMES[static_cast<int>(status.activeEngine)]);
+            ImGui::TextWrapped("Reason: %s", status.engineSelectionReason.c_str());
 
-            ImGui::Checkbox("Is running", &sim.isRunning);
+            if (statistics.isValid)
+            {
+                ImGui::Text("Generation: %llu, population: %llu", (unsigned long long)statistics.generation, (unsigned long long)statistics.population);
+            }
         }
         ImGui::Dummy({ 0, 20 });
 
@@ -236,6 +370,7 @@ void UI(Simulation& sim, Shader& cellsShader)
 
         {
             ImGui::Text("Kernel:");
+            ScopedCpuZone kernelZone(CpuZone::KernelDrawList);
 
             int kernelSize = rules.neighborSearchRange * 2 + 1;
 
@@ -325,14 +460,66 @@ void UI(Simulation& sim, Shader& cellsShader)
 
         ImGui::EndTabItem();
 	}
+
+    if (ImGui::BeginTabItem("History"))
+    {
+        int recordsCount = history.getRecordsCount();
+        ImGui::Text("%d generations kept, %.1f MB", recordsCount, history.getUsedBytes() / (1024.0 * 1024.0));
+        ImGui::Text("Frames dropped while compressing: %llu", (unsigned long long)history.getDroppedFrames());
+
+        int budgetMegabytes = (int)(history.getBudget() >> 20);
+        if (ImGui::SliderInt("Memory budget (MB)", &budgetMegabytes, 16, 4096))
+        {
+            history.setBudget((size_t)budgetMegabytes << 20);
+        }
+
+        // Scrubbing pauses the simulation, every move restores the chosen generation
+        static int rewindIndex = 0;
+        if (recordsCount > 0)
+        {
+            rewindIndex = std::min(rewindIndex, recordsCount - 1);
+            char generationText[32];
+            snprintf(generationText, sizeof(generationText), "Generation %llu", (unsigned long long)history.getGeneration(rewindIndex));
+            if (ImGui::SliderInt("Rewind", &rewindIndex, 0, recordsCount - 1, generationText))
+            {
+                std::vector<uint8_t> cells;
+                uint64_t generation = 0;
+                if (history.getCells(rewindIndex, cells, generation))
+                {
+                    // The pause goes out first, otherwise the restored generation could be stepped and recorded
+                    settings.isRunning = false;
+                    simThread.postSettings(settings);
+                    simThread.post([cells = std::move(cells), generation](Simulation& s) { s.restore(cells, generation); });
+                    history.markRestored(generation);
+                }
+            }
+        }
+        else
+        {
+            ImGui::Text("No generations captured yet");
+        }
+
+        ImGui::EndTabItem();
+    }
+
+    if (ImGui::BeginTabItem("Performance"))
+    {
+        ProfilerUI::drawGpuStatistics();
+        ImGui::Dummy({ 0, 20 });
+
+        ProfilerUI::drawCpuTimeline();
+        ImGui::Dummy({ 0, 20 });
+
+        ProfilerUI::drawTraceControls();
+
+        ImGui::EndTabItem();
+    }
 	
     ImGui::EndTabBar();
 
 	ImGui::End();
 
-	// Sumbit values to compute shader
-    // TODO: update only when settings got changed
-	sim.submitRulesToShader();
+    simThread.postSettings(settings);
 
 	// TODO: Add ability to save and load rules
 	// TODO: Add ability to choose kernel generation method (only positive ints, only 0 or 1, only positives, any)
@@ -340,13 +527,64 @@ void UI(Simulation& sim, Shader& cellsShader)
     // TODO; Add ability to use keyboard for changing settings
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    CommandLineOptions options = parseCommandLine(argc, argv);
+
     GLFWwindow* window = initOpenGLWindow(WINDOW_W, WINDOW_H, "Cellular automata");
     if (!window)
         return -1;
 
-	glfwSwapInterval(1); // Enable vsync
+    // Start tracing before the shaders get compiled
+    TraceRecorder::setThreadName("Main");
+    if (!options.tracePath.empty())
+    {
+        TraceRecorder::calibrateGpuClock();
+        TraceRecorder::setEnabled(true);
+    }
+
+    // Tool modes run without the interactive loop
+    bool isCpuWorldTool = !options.outOfCore.storePath.empty() || options.isRunningSparseWorld;
+    if (!options.benchmarkPath.empty() || !options.conformancePath.empty() || isCpuWorldTool)
+    {
+        bool isSuccess = true;
+        if (isCpuWorldTool)
+        {
+            EngineCostModel costModel;
+            costModel.loadOrCalibrate("engine_costs.txt");
+            if (!options.outOfCore.storePath.empty())
+            {
+                isSuccess = OutOfCoreSimulation::run(options.outOfCore, costModel);
+            }
+            if (options.isRunningSparseWorld)
+            {
+                isSuccess = SparseWorld::run(options.sparseWorld, costModel) && isSuccess;
+            }
+        }
+        if (!options.conformancePath.empty())
+        {
+            ConformanceConfig config;
+            bool isConformanceSuccess = options.isGeneratingGolden
+                ? Conformance::generateGolden(config, options.conformancePath)
+                : Conformance::run(config, options.conformancePath);
+            isSuccess = isConformanceSuccess && isSuccess;
+        }
+        if (!options.benchmarkPath.empty())
+        {
+            BenchmarkConfig config = options.isQuickBenchmark ? BenchmarkConfig::createQuick() : BenchmarkConfig();
+            isSuccess = Benchmark::run(config, options.benchmarkPath) && isSuccess;
+        }
+
+        if (!options.tracePath.empty())
+        {
+            TraceRecorder::save(options.tracePath);
+        }
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return isSuccess ? 0 : -1;
+    }
+
+	glfwSwapInterval(1); // Enable vsync, only the UI is tied to it, the simulation runs on its own thread
 
     // Create two 2D textures
     Texture2D textureA(GRID_W, GRID_H, GL_R8UI, GL_RED_INTEGER, GL_UNSIGNED_BYTE);
@@ -384,11 +622,23 @@ int main()
 	ColorPalette::generateRandomHSV(simulation.visuals.aliveColor, simulation.visuals.deadColor);
 	simulation.submitVisualsToShader(cellsRendererShader);
 
+    // Measured once per machine, the engine is then chosen from the predicted cost of the current rules
+    simulation.costModel.loadOrCalibrate("engine_costs.txt");
+
     double previousTime = glfwGetTime();
     double uiUpdateTime = previousTime;
     int frameCount = 0;
     int updatesCount = 0;
 
+    // Everything the simulation uses is created by now, from here on it is stepped on its own thread
+    SimulationThread simulationThread(window, simulation, GRID_W, GRID_H);
+    if (!simulationThread.start())
+    {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return -1;
+    }
+
 	// imgui initialization
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -398,14 +648,61 @@ int main()
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 460");
 
+    // Cell data is read back asynchronously and handed to consumers a few frames later
+    TextureReadback readback(GRID_W, GRID_H);
+    uint64_t lastRequestedGeneration = 0;
+    uint64_t lastRequestedCellsVersion = 0;
+
+    GpuTimer cellsDrawTimer(GpuZone::CellsDraw);
+    GpuTimer imguiRenderTimer(GpuZone::ImGuiRender);
+
+    WorldStatistics statistics;
+    std::vector<uint8_t> previousFrameCells;
+    readback.addConsumer([&statistics, &previousFrameCells, &simulation](const ReadbackFrame& frame)
+        {
+            uint64_t population = 0;
+            uint64_t changedCells = 0;
+            bool hasPreviousFrame = statistics.isValid && previousFrameCells.size() == (size_t)frame.width * frame.height;
+            for (int i = 0; i < frame.width * frame.height; ++i)
+            {
+                population += frame.data[i];
+                if (hasPreviousFrame)
+                {
+                    changedCells += frame.data[i] != previousFrameCells[i];
+                }
+            }
+
+            // Fraction of cells changed per generation, used by the engine selection
+            if (hasPreviousFrame && frame.generation > statistics.generation)
+            {
+                double generations = (double)(frame.generation - statistics.generation);
+                simulation.setObservedActivity(std::min((double)changedCells / (frame.width * frame.height) / generations, 1.0));
+            }
+            previousFrameCells.assign(frame.data, frame.data + (size_t)frame.width * frame.height);
+
+            statistics.isValid = true;
+            statistics.generation = frame.generation;
+            statistics.population = population;
+        });
+
+    // Every generation that is read back is kept for rewinding
+    RewindHistory history(GRID_W, GRID_H, (size_t)REWIND_BUDGET_MB << 20);
+    readback.addConsumer([&history](const ReadbackFrame& frame)
+        {
+            history.push(frame);
+        });
+
     // Main loop
     while (!glfwWindowShouldClose(window))
     {
+        CpuProfiler::beginFrame();
+        ScopedCpuZone frameZone(CpuZone::Frame);
+
         double currentTime = glfwGetTime();
         double deltaTime = currentTime - previousTime;
         if (deltaTime > 0.5)
         {
-            deltaTime = 0.0;
+            // Only the title counters restart after a hitch, the simulation bounds its own backlog
             uiUpdateTime = currentTime;
             frameCount = 0;
 			updatesCount = 0;
@@ -428,42 +725,87 @@ int main()
         }
         frameCount++;
 
-        // Switch texture every 1/SIMULATION_UPDATE_RATE seconds
-        updatesCount += simulation.update(deltaTime);
-
-        // Clear screen
-        glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        // Take the newest generation the simulation thread published
+        simulationThread.acquireFrame();
+        updatesCount += simulationThread.takeUpdatesCount();
 
-        if (simulation.useTextureA)
+        // Queue a copy of the newest generation and deliver the ones that already arrived.
+        // Randomized or restored cells keep the generation, so they are told apart by the cells version.
         {
-            textureA.bind(GL_TEXTURE0);
+            ScopedCpuZone readbackZone(CpuZone::Readback);
+            const SimulationStatus& frameStatus = simulationThread.getFrameStatus();
+            bool isNewFrame = frameStatus.generation != lastRequestedGeneration || frameStatus.cellsVersion != lastRequestedCellsVersion;
+            if (simulationThread.hasFrame() && readback.hasConsumers() && (isNewFrame || !statistics.isValid))
+            {
+                if (readback.request(simulationThread.getFrameTexture(), frameStatus.generation))
+                {
+                    lastRequestedGeneration = frameStatus.generation;
+                    lastRequestedCellsVersion = frameStatus.cellsVersion;
+                }
+            }
+            readback.poll();
         }
-        else
+
         {
-            textureB.bind(GL_TEXTURE0);
-        }
+            ScopedCpuZone drawZone(CpuZone::CellsDraw);
 
-        cellsRendererShader.use();
+            // Clear screen
+            glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
 
-        vao.bind();
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+            cellsDrawTimer.beginFrame();
+            if (simulationThread.hasFrame())
+            {
+                simulationThread.getFrameTexture().bind(GL_TEXTURE0);
+                cellsRendererShader.use();
 
-        // imgui new frame
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+                cellsDrawTimer.begin();
+                vao.bind();
+                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                cellsDrawTimer.end();
+            }
+        }
 
-        //
-        UI(simulation, cellsRendererShader);
+        {
+            ScopedCpuZone uiZone(CpuZone::UIBuild);
 
-        // imgui render
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            // imgui new frame
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+
+            //
+            UI(simulation, simulationThread, cellsRendererShader, statistics, history);
+        }
+
+        {
+            ScopedCpuZone imguiZone(CpuZone::ImGuiRender);
+
+            // imgui render
+            ImGui::Render();
+            imguiRenderTimer.beginFrame();
+            imguiRenderTimer.begin();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            imguiRenderTimer.end();
+        }
 
 		// Swap buffers and poll events
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            ScopedCpuZone swapZone(CpuZone::SwapBuffers);
+            glfwSwapBuffers(window);
+        }
+        {
+            ScopedCpuZone pollZone(CpuZone::PollEvents);
+            glfwPollEvents();
+        }
+    }
+
+    simulationThread.stop();
+
+    if (!options.tracePath.empty())
+    {
+        TraceRecorder::setEnabled(false);
+        TraceRecorder::save(options.tracePath);
     }
 
     //  ImGui